@@ -0,0 +1,29 @@
+/*! \file */
+
+#pragma once
+
+#include "NextionTypes.h"
+
+class INextionTouchable;
+
+/*!
+ * \class INextionCallback
+ * \brief Interface for objects that handle events of touchable widgets.
+ *
+ * An alternative to callback functions, see
+ * INextionTouchable::attachCallback(INextionCallback *).
+ */
+class INextionCallback
+{
+public:
+    virtual ~INextionCallback()
+    {
+    }
+
+    /*!
+     * \brief Handles an event.
+     * \param type Type of the event
+     * \param widget Widget that raised the event
+     */
+    virtual void handleNextionEvent(NextionEventType type, INextionTouchable *widget) = 0;
+};
@@ -0,0 +1,69 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+/*!
+ * \class INextionChannel
+ * \brief Interface for handlers of custom unsolicited messages.
+ *
+ * A channel owns a header byte not used by the device itself. Messages sent
+ * by the HMI (e.g. with printh/prints) consisting of the header, exactly
+ * getPayloadLength() bytes of payload and the usual FF FF FF termination are
+ * passed to processMessage() from Nextion::poll(). As the length is known the
+ * payload may contain any bytes, including 0xFF.
+ *
+ * Channels are registered with Nextion::registerChannel().
+ */
+class INextionChannel
+{
+public:
+    /*!
+     * \brief Creates a new channel.
+     * \param header Header byte of the messages
+     * \param payloadLength Number of bytes following the header
+     */
+    INextionChannel(uint8_t header, size_t payloadLength)
+        : m_header(header)
+        , m_payloadLength(payloadLength)
+    {
+    }
+
+    virtual ~INextionChannel()
+    {
+    }
+
+    /*!
+     * \brief Gets the header byte of the messages.
+     * \return Header byte
+     */
+    uint8_t getHeader() const
+    {
+        return m_header;
+    }
+
+    /*!
+     * \brief Gets the number of bytes following the header.
+     * \return Payload length
+     */
+    size_t getPayloadLength() const
+    {
+        return m_payloadLength;
+    }
+
+    /*!
+     * \brief Called for each message received on the channel.
+     * \param payload Bytes following the header
+     * \param length Number of bytes, always getPayloadLength()
+     */
+    virtual void processMessage(const uint8_t *payload, size_t length) = 0;
+
+protected:
+    const uint8_t m_header;       //!< Header byte of the messages
+    const size_t m_payloadLength; //!< Number of bytes following the header
+};
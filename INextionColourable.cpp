@@ -1,6 +1,7 @@
 /*! \file */
 
 #include "INextionColourable.h"
+#include "NextionStyle.h"
 
 /*!
  * \copydoc INextionWidget::INextionWidget
@@ -130,25 +131,50 @@ bool INextionColourable::getColour(const String &type, uint32_t &colour)
     return getNumberProperty(type, colour);
 }
 
+/*!
+ * \brief Appends the colour assignments of a style to a batch.
+ * \param batch Batch to append to
+ * \param style Style, colours set to NEX_COL_NONE are skipped
+ * \see NextionStyle::applyTo
+ */
+void INextionColourable::appendColours(NextionCommandBatch &batch, const NextionStyle &style) const
+{
+    const uint32_t none = NEX_COL_NONE;
+    if (style.foregroundColour != none)
+    {
+        batch.addf("%s.pco=%u", m_name.c_str(), style.foregroundColour);
+    }
+    if (style.eventForegroundColour != none)
+    {
+        batch.addf("%s.pco2=%u", m_name.c_str(), style.eventForegroundColour);
+    }
+    if (style.backgroundColour != none)
+    {
+        batch.addf("%s.bco=%u", m_name.c_str(), style.backgroundColour);
+    }
+    if (style.eventBackgroundColour != none)
+    {
+        batch.addf("%s.bco2=%u", m_name.c_str(), style.eventBackgroundColour);
+    }
+}
+
 /*!
  * \brief Handles refreshing the page after a colour has been changed.
  * \param result Success of colour set
  * \param refresh If the widget should be refreshed
  * \return True if successful
  * \see INextionColourable::getColour
+ * \see Nextion::requestRefresh
  */
 bool INextionColourable::afterSet(bool result, bool refresh)
 {
-    if (result)
+    if (!result)
     {
-        if (refresh)
-        {
-            m_nextion.refresh(m_name);
-            return m_nextion.checkCommandComplete();
-        }
-        else
-            return true;
-    }
-    else
         return false;
+    }
+    if (!refresh)
+    {
+        return true;
+    }
+    return m_nextion.requestRefresh(m_name);
 }
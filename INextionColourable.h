@@ -6,6 +6,9 @@
 #include "Nextion.h"
 #include "NextionTypes.h"
 
+class NextionCommandBatch;
+class NextionStyle;
+
 /*!
  * \class INextionColourable
  * \brief Interface for widgets that can be coloured.
@@ -30,5 +33,7 @@ public:
     bool setColour(const String &type, uint32_t colour, bool refresh);
     bool getColour(const String &type, uint32_t &colour);
 
+    void appendColours(NextionCommandBatch &batch, const NextionStyle &style) const;
+
     bool afterSet(bool result, bool refresh);
 };
@@ -1,6 +1,7 @@
 /*! \file */
 
 #include "INextionFontStyleable.h"
+#include "NextionStyle.h"
 
 /*!
  * \copydoc INextionWidget::INextionWidget
@@ -100,24 +101,44 @@ bool INextionFontStyleable::getVAlignment(NextionFontAlignment &align)
     return false;
 }
 
+/*!
+ * \brief Appends the font assignments of a style to a batch.
+ * \param batch Batch to append to
+ * \param style Style, a font of -1 and alignments of NEX_FA_NONE are skipped
+ * \see NextionStyle::applyTo
+ */
+void INextionFontStyleable::appendFontStyle(NextionCommandBatch &batch, const NextionStyle &style) const
+{
+    if (style.font >= 0)
+    {
+        batch.addf("%s.font=%d", m_name.c_str(), style.font);
+    }
+    if (style.hAlignment != NEX_FA_NONE)
+    {
+        batch.addf("%s.xcen=%d", m_name.c_str(), style.hAlignment);
+    }
+    if (style.vAlignment != NEX_FA_NONE)
+    {
+        batch.addf("%s.ycen=%d", m_name.c_str(), style.vAlignment);
+    }
+}
+
 /*!
  * \brief Handles refreshing the page after a style has been changed.
  * \param result Success of style change
  * \param refresh If the widget should be refreshed
  * \return True if successful
+ * \see Nextion::requestRefresh
  */
 bool INextionFontStyleable::afterSet(bool result, bool refresh)
 {
-    if (result)
+    if (!result)
     {
-        if (refresh)
-        {
-            m_nextion.refresh(m_name);
-            return m_nextion.checkCommandComplete();
-        }
-        else
-            return true;
-    }
-    else
         return false;
+    }
+    if (!refresh)
+    {
+        return true;
+    }
+    return m_nextion.requestRefresh(m_name);
 }
@@ -6,6 +6,9 @@
 #include "Nextion.h"
 #include "NextionTypes.h"
 
+class NextionCommandBatch;
+class NextionStyle;
+
 /*!
  * \class INextionFontStyleable
  * \brief Interface for widgets that can have their fonts styled.
@@ -24,5 +27,7 @@ public:
     bool setVAlignment(NextionFontAlignment align, bool refresh = true);
     bool getVAlignment(NextionFontAlignment &align);
 
+    void appendFontStyle(NextionCommandBatch &batch, const NextionStyle &style) const;
+
     bool afterSet(bool result, bool refresh);
 };
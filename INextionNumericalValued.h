@@ -44,4 +44,17 @@ public:
     {
         return setNumberProperty("val", value);
     }
+
+    /*!
+   * \brief Queues the numerical value to be sent by Nextion::poll().
+   * \param value Value
+   * \param priority Priority class of the write
+   * \param maxAge Time in ms after which the write is dropped, 0 for never
+   * \return True if successful
+   * \see INextionWidget::queueNumberProperty
+   */
+    bool queueValue(uint32_t value, NextionPriority priority = NEX_PRIO_TELEMETRY, uint32_t maxAge = 0)
+    {
+        return queueNumberProperty("val", value, priority, maxAge);
+    }
 };
@@ -0,0 +1,30 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+/*!
+ * \class INextionPageListener
+ * \brief Interface for objects that need to know when the displayed page
+ *        changes.
+ *
+ * Listeners are registered with Nextion::registerPageListener().
+ */
+class INextionPageListener
+{
+public:
+    virtual ~INextionPageListener()
+    {
+    }
+
+    /*!
+     * \brief Called after the displayed page has changed.
+     * \param pageID ID of the page now displayed
+     */
+    virtual void pageChanged(uint8_t pageID) = 0;
+};
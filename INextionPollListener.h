@@ -0,0 +1,29 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+/*!
+ * \class INextionPollListener
+ * \brief Interface for objects that have work to do on every Nextion::poll(),
+ *        e.g. delivering values held back by a rate limit.
+ *
+ * Listeners are registered with Nextion::registerPollListener().
+ */
+class INextionPollListener
+{
+public:
+    virtual ~INextionPollListener()
+    {
+    }
+
+    /*!
+     * \brief Called at the end of every Nextion::poll().
+     */
+    virtual void polled() = 0;
+};
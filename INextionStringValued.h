@@ -34,6 +34,19 @@ public:
         return getStringProperty("txt", buffer);
     }
 
+    /*!
+   * \brief Gets the value of the string into a caller provided buffer.
+   * \param buffer Buffer to store the string in, always null terminated
+   * \param size Size of the buffer in bytes
+   * \return Actual length of string, the string was truncated if this is not
+   *         less than size
+   * \see INextionWidget::getStringProperty
+   */
+    size_t getText(char *buffer, size_t size)
+    {
+        return getStringProperty("txt", buffer, size);
+    }
+
     /*!
    * \brief Sets the value of the string.
    * \param buffer Value
@@ -45,6 +58,19 @@ public:
         return setStringProperty("txt", buffer);
     }
 
+    /*!
+   * \brief Queues the value of the string to be sent by Nextion::poll().
+   * \param buffer Value
+   * \param priority Priority class of the write
+   * \param maxAge Time in ms after which the write is dropped, 0 for never
+   * \return True if successful
+   * \see INextionWidget::queueStringProperty
+   */
+    bool queueText(const String &buffer, NextionPriority priority = NEX_PRIO_TELEMETRY, uint32_t maxAge = 0)
+    {
+        return queueStringProperty("txt", buffer, priority, maxAge);
+    }
+
     /*!
    * \brief Sets the text by a numercal value.
    * \param value Numerical value
@@ -64,10 +90,11 @@ public:
    */
     bool getTextAsNumber(uint32_t& value)
     {
-        String buffer;
-        if (getStringProperty("txt", buffer))
+        char buffer[16];
+        size_t length = getStringProperty("txt", buffer, sizeof(buffer));
+        if (length > 0 && length < sizeof(buffer))
         {
-            value = buffer.toInt();
+            value = strtoul(buffer, nullptr, 10);
             return true;
         }
         return false;
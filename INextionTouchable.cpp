@@ -70,6 +70,27 @@ bool INextionTouchable::attachCallback(const NextionCallback &callback)
     return true;
 }
 
+/*!
+ * \brief Attaches a callback handler object to this widget.
+ * \param handler Handler, must outlive the attachment
+ * \return True if successful
+ * \see INextionTouchable::detachCallback
+ *
+ * Only a pointer is stored, so this never allocates.
+ */
+bool INextionTouchable::attachCallback(INextionCallback *handler)
+{
+    if (!handler)
+    {
+        return false;
+    }
+
+    m_callback = [handler](NextionEventType type, INextionTouchable *widget) {
+        handler->handleNextionEvent(type, widget);
+    };
+    return true;
+}
+
 /*!
  * \brief Removes the callback handler from this widget
  */
@@ -4,8 +4,26 @@
 
 #include <functional>
 #include "Nextion.h"
+#include "INextionCallback.h"
 #include "INextionWidget.h"
 
+// Define to store callbacks in place instead of in std::function, which may
+// allocate for larger captures. This changes the layout of INextionTouchable,
+// NextionSlider and NextionValueSubscription, so it has to be set for the whole
+// build, e.g. here or as a compiler flag (-DNEXTION_INPLACE_CALLBACK), together
+// with NEXTION_INPLACE_CALLBACK_SIZE. Defining either in a sketch before the
+// includes leaves the library compiled with another layout, which corrupts
+// memory at run time.
+//#define NEXTION_INPLACE_CALLBACK
+
+#ifdef NEXTION_INPLACE_CALLBACK
+#include "NextionInplaceFunction.h"
+
+#ifndef NEXTION_INPLACE_CALLBACK_SIZE
+#define NEXTION_INPLACE_CALLBACK_SIZE (2 * sizeof(void *)) //!< Bytes available for captures
+#endif
+#endif
+
 /*!
  * \class INextionTouchable
  * \brief Interface for widgets that can be touched.
@@ -13,19 +31,28 @@
 class INextionTouchable : public virtual INextionWidget
 {
 public:
+#ifdef NEXTION_INPLACE_CALLBACK
+    /*!
+   * \typedef NextionCallback
+   * \brief Event handler function for display events.
+   */
+    typedef NextionInplaceFunction<void(NextionEventType, INextionTouchable *), NEXTION_INPLACE_CALLBACK_SIZE> NextionCallback;
+#else
     /*!
    * \typedef NextionCallback
    * \brief Event handler function for display events.
    */
     typedef std::function<void(NextionEventType, INextionTouchable *)> NextionCallback;
+#endif
 
     INextionTouchable(Nextion &nex, uint8_t page, uint8_t component,
                       const String &name);
     virtual ~INextionTouchable();
 
-    bool processEvent(uint8_t pageID, uint8_t componentID, uint8_t eventType);
+    virtual bool processEvent(uint8_t pageID, uint8_t componentID, uint8_t eventType);
 
     bool attachCallback(const NextionCallback &cb);
+    bool attachCallback(INextionCallback *handler);
     void detachCallback();
 
 private:
@@ -1,6 +1,7 @@
 /*! \file */
 
 #include "INextionWidget.h"
+#include "NextionEscape.h"
 
 /*!
  * \brief Create a new widget adapter.
@@ -63,14 +64,32 @@ const String &INextionWidget::getName() const
     return m_name;
 }
 
+/*!
+ * \brief Gets the driver of the device this widget is on.
+ * \return Driver
+ */
+Nextion &INextionWidget::getNextion()
+{
+    return m_nextion;
+}
+
 /*!
  * \brief Sets the value of a numerical property of this widget.
  * \param propertyName Name of the property
  * \param value Value
  * \return True if successful
+ *
+ * The write is retained for replay after a restart of the device if the state
+ * store is enabled, see Nextion::recover().
  */
 bool INextionWidget::setNumberProperty(const String &propertyName, uint32_t value)
 {
+    NextionStateStore &store = m_nextion.getStateStore();
+    if (store.isEnabled())
+    {
+        String key = m_name + "." + propertyName;
+        store.retain(m_pageID, key, key + "=" + String(static_cast<int32_t>(value)));
+    }
     return sendCommandWithWait("%s.%s=%d", m_name.c_str(), propertyName.c_str(), value);
 }
 
@@ -91,10 +110,23 @@ bool INextionWidget::getNumberProperty(const String &propertyName, uint32_t &val
  * \param propertyName Name of the property
  * \param value Value
  * \return True if successful
+ *
+ * The write is retained for replay after a restart of the device if the state
+ * store is enabled, see Nextion::recover().
  */
 bool INextionWidget::setStringProperty(const String &propertyName, const String &value)
 {
-    return sendCommandWithWait("%s.%s=\"%s\"", m_name.c_str(), propertyName.c_str(), value.c_str());
+    NextionStateStore &store = m_nextion.getStateStore();
+    if (store.isEnabled())
+    {
+        String key = m_name + "." + propertyName;
+        String command = key + "=\"";
+        NextionEscape::append(command, value.c_str(), value.length());
+        command += '\"';
+        store.retain(m_pageID, key, command);
+    }
+    m_nextion.sendCommandWithString(value, "%s.%s=", m_name.c_str(), propertyName.c_str());
+    return m_nextion.checkCommandComplete();
 }
 
 /*!
@@ -109,6 +141,90 @@ size_t INextionWidget::getStringProperty(const String &propertyName, String &buf
     return m_nextion.receiveString(buffer);
 }
 
+/*!
+ * \brief Gets the value of a string property of this widget without using a
+ *        String.
+ * \param propertyName Name of the property
+ * \param buffer Buffer to store the value in, always null terminated
+ * \param size Size of the buffer in bytes
+ * \return Actual length of value, the value was truncated if this is not less
+ *         than size
+ */
+size_t INextionWidget::getStringProperty(const String &propertyName, char *buffer, size_t size)
+{
+    sendCommand("get %s.%s", m_name.c_str(), propertyName.c_str());
+    return m_nextion.receiveString(buffer, size);
+}
+
+/*!
+ * \brief Queues a write to a numerical property of this widget.
+ * \param propertyName Name of the property
+ * \param value Value
+ * \param priority Priority class of the write
+ * \param maxAge Time in ms after which the write is dropped if it has not been
+ *               sent yet, 0 to never drop it
+ * \return True if the write was queued
+ *
+ * A write to the same property that has not been sent yet is replaced.
+ */
+bool INextionWidget::queueNumberProperty(const String &propertyName, uint32_t value,
+                                         NextionPriority priority, uint32_t maxAge)
+{
+    String key = m_name + "." + propertyName;
+    String command = key + "=" + String(static_cast<int32_t>(value));
+    NextionStateStore &store = m_nextion.getStateStore();
+    if (store.isEnabled())
+    {
+        store.retain(m_pageID, key, command, priority);
+    }
+    return m_nextion.queueCommand(priority, command, maxAge, key);
+}
+
+/*!
+ * \brief Queues a write to a string property of this widget.
+ * \param propertyName Name of the property
+ * \param value Value
+ * \param priority Priority class of the write
+ * \param maxAge Time in ms after which the write is dropped if it has not been
+ *               sent yet, 0 to never drop it
+ * \return True if the write was queued
+ *
+ * A write to the same property that has not been sent yet is replaced.
+ */
+bool INextionWidget::queueStringProperty(const String &propertyName, const String &value,
+                                         NextionPriority priority, uint32_t maxAge)
+{
+    String key = m_name + "." + propertyName;
+    String command = key + "=\"";
+    NextionEscape::append(command, value.c_str(), value.length());
+    command += '\"';
+    NextionStateStore &store = m_nextion.getStateStore();
+    if (store.isEnabled())
+    {
+        store.retain(m_pageID, key, command, priority);
+    }
+    return m_nextion.queueCommand(priority, command, maxAge, key);
+}
+
+/*!
+ * \brief Sends a batch of commands changing this widget.
+ * \param batch Commands to send
+ * \param refresh If the widget should be refreshed afterwards
+ * \return True if successful
+ */
+bool INextionWidget::applyBatch(const NextionCommandBatch &batch, bool refresh)
+{
+    if (!m_nextion.sendBatch(batch))
+    {
+        return false;
+    }
+    if (!refresh || batch.getCommandCount() == 0)
+    {
+        return true;
+    }
+    return m_nextion.requestRefresh(m_name);
+}
+
 void INextionWidget::sendCommand(const String &format, ...)
 {
     va_list args;
@@ -129,6 +245,12 @@ bool INextionWidget::sendCommandWithWait(const String &format, ...)
 
 bool INextionWidget::setPropertyCommand(const String &command, uint32_t value)
 {
+    NextionStateStore &store = m_nextion.getStateStore();
+    if (store.isEnabled())
+    {
+        store.retain(m_pageID, command + " " + m_name,
+                     command + " " + m_name + "," + String(static_cast<int32_t>(value)));
+    }
     m_nextion.sendCommand("%s %s,%d", command.c_str(), m_name.c_str(), value);
     return m_nextion.checkCommandComplete();
 }
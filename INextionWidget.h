@@ -21,12 +21,21 @@ public:
     uint8_t getPageID();
     uint8_t getComponentID();
     const String& getName() const;
+    Nextion &getNextion();
 
     bool setNumberProperty(const String &propertyName, uint32_t value);
     bool getNumberProperty(const String &propertyName, uint32_t &value);
     bool setPropertyCommand(const String &command, uint32_t value);
     bool setStringProperty(const String &propertyName, const String &value);
     size_t getStringProperty(const String &propertyName, String &buffer);
+    size_t getStringProperty(const String &propertyName, char *buffer, size_t size);
+
+    bool queueNumberProperty(const String &propertyName, uint32_t value,
+                             NextionPriority priority = NEX_PRIO_TELEMETRY, uint32_t maxAge = 0);
+    bool queueStringProperty(const String &propertyName, const String &value,
+                             NextionPriority priority = NEX_PRIO_TELEMETRY, uint32_t maxAge = 0);
+
+    bool applyBatch(const NextionCommandBatch &batch, bool refresh);
 
     bool setVisible(bool visible);
     bool enable(bool enable);
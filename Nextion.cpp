@@ -1,53 +1,50 @@
 /*! \file */
 
 #include "Nextion.h"
+#include "INextionChannel.h"
+#include "INextionPageListener.h"
+#include "INextionPollListener.h"
 #include "INextionTouchable.h"
+#include "NextionEscape.h"
 #include "NextionLogger.h"
+#include "NextionValueSubscription.h"
 #include <FS.h>
 #include <MD5Builder.h>
+#include <algorithm>
 #include <vector>
 
-/*!
- * \brief Determines if the message is solicited vs unsolicited.
- * Unsolicited means it is an event raised by the device on its own (e.g. not
- * due to a request by this lib) \param commandId Message command ID
- */
-static bool isMessageUnsolicited(uint8_t commandId)
-{
-    return commandId == NEX_RET_EVENT_TOUCH_HEAD ||
-           commandId == NEX_RET_EVENT_POSITION_HEAD ||
-           commandId == NEX_RET_EVENT_SLEEP_POSITION_HEAD;
-}
-
-/*!
- * \brief Calculates the message length in a buffer.
- * \param buffer Message buffer
- * \param start Start index
- * \param length Length of the message (including termination bytes) found
- * \return True if a message was found.
- */
-static bool calcMessageLength(const std::vector<uint8_t> &buffer, std::size_t start,
-                              std::size_t &length)
-{
-    for (std::size_t i = start + 2; i < buffer.size(); ++i)
-    {
-        if (buffer[i - 2] == 0xFF && buffer[i - 1] == 0xFF && buffer[i] == 0xFF)
-        {
-            length = i - start - 2;
-            return true;
-        }
-    }
-    return false;
-}
-
 /*!
  * \brief Creates a new device driver.
  * \param stream Stream (serial port) the device is connected to
+ * \param timeout Longest time to wait for a reply in ms
  */
 Nextion::Nextion(Stream &stream, uint16_t timeout)
     : m_serialPort(stream)
-    , m_timeout(timeout)
+    , m_currentPage(0)
+    , m_pageRequested(false)
     , m_commandResultRequired(false)
+    , m_deferEvents(false)
+    , m_dispatchOnPoll(true)
+    , m_eventOverflows(0)
+    , m_deferRefresh(false)
+    , m_refreshAllThreshold(8)
+    , m_rawReplyHeader(0)
+    , m_rawReplyLength(0)
+    , m_messageLength(0)
+    , m_eventTimestamp(0)
+    , m_linkMonitor(timeout)
+    , m_lastWriteTime(0)
+    , m_lastWriteSize(0)
+    , m_replyPending(false)
+    , m_recoveryPending(false)
+    , m_recoveries(0)
+    , m_lastCommand(0)
+    , m_retries(0)
+    , m_throttle(0)
+    , m_discarding(false)
+    , m_parseErrors(0)
+    , m_slowReply(false)
+    , m_replyLate(false)
 {
     m_buffer.reserve(32);
     m_solicitedBuffer.reserve(32);
@@ -62,13 +59,19 @@ Nextion::Nextion(Stream &stream, uint16_t timeout)
 bool Nextion::init()
 {
     m_buffer.clear();
+    m_reframeBuffer.clear();
 
     // Don't check the result from the following command
     // since in latest Nextion firmwares, bkcmd=3 is returning 1A FF FF FF
     requireCommandResult(true);
 
     sendCommand("page 0");
-    return checkCommandComplete();
+    if (checkCommandComplete())
+    {
+        notifyPageChanged(0);
+        return true;
+    }
+    return false;
 }
 
 /*!
@@ -84,6 +87,7 @@ bool Nextion::requireCommandResult(bool require)
         if (checkCommandComplete(true))
         {
             m_commandResultRequired = true;
+            m_flowControl.setAcknowledged(true);
             return true;
         }
         return false;
@@ -92,17 +96,154 @@ bool Nextion::requireCommandResult(bool require)
     {
         sendCommand("bkcmd=0");
         m_commandResultRequired = false;
+        m_flowControl.setAcknowledged(false);
         return true;
     }
 }
 
 /*!
- * \brief Polls for unsolicited messages (e.g. touch events) and processes them
+ * \brief Polls for unsolicited messages (e.g. touch events) and processes them,
+ *        then sends queued commands as far as the bandwidth budgets allow.
+ *
+ * When touch events are deferred they are dispatched after all received
+ * messages have been parsed, unless dispatching was left to the caller.
+ * Deferred refreshes are flushed last. A dead link is probed first when a
+ * probe is due. If the device restarted (NEX_RET_EVENT_LAUNCHED was received or
+ * a dead link replies again) its state is recovered before anything else is
+ * sent.
  */
 void Nextion::poll()
 {
+    if (m_linkMonitor.isProbeDue() && checkLink())
+    {
+        // The device may have restarted while it did not reply
+        m_recoveryPending = true;
+    }
     readMessage(false);
     processUnsolicited();
+    if (m_recoveryPending)
+    {
+        recover();
+    }
+    if (m_deferEvents && m_dispatchOnPoll)
+    {
+        dispatchEvents();
+    }
+    processQueue();
+    flushRefresh();
+    for (auto iter = m_pollListenerList.cbegin(); iter != m_pollListenerList.cend(); ++iter)
+    {
+        (*iter)->polled();
+    }
+}
+
+/*!
+ * \brief Determines if the message is solicited vs unsolicited.
+ * Unsolicited means it is an event raised by the device on its own (e.g. not
+ * due to a request by this lib), including messages of registered channels.
+ * \param commandId Message command ID
+ */
+bool Nextion::isMessageUnsolicited(uint8_t commandId) const
+{
+    return commandId == NEX_RET_EVENT_TOUCH_HEAD ||
+           commandId == NEX_RET_EVENT_POSITION_HEAD ||
+           commandId == NEX_RET_EVENT_SLEEP_POSITION_HEAD ||
+           commandId == NEXTION_VALUE_CHANGE_HEAD ||
+           commandId == NEXTION_VALUE_FINAL_HEAD ||
+           commandId == NEX_RET_EVENT_LAUNCHED ||
+           (commandId == NEX_RET_CURRENT_PAGE_ID_HEAD && !m_pageRequested) ||
+           findChannel(commandId) != nullptr;
+}
+
+/*!
+ * \brief Finds the registered channel of a header byte.
+ * \param header Header byte
+ * \return Channel, null if none is registered
+ */
+INextionChannel *Nextion::findChannel(uint8_t header) const
+{
+    for (auto iter = m_channelList.cbegin(); iter != m_channelList.cend(); ++iter)
+    {
+        if ((*iter)->getHeader() == header)
+        {
+            return *iter;
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * \brief Gets the length of messages that have a fixed size.
+ * \param commandId Message command ID
+ * \return Length of the message (excluding termination bytes), 0 if it varies
+ *
+ * Payloads of such messages may contain 0xFF bytes, e.g. a number of -1, so
+ * the termination bytes are only looked for after the payload.
+ */
+std::size_t Nextion::getFixedMessageLength(uint8_t commandId) const
+{
+    if (m_rawReplyLength > 0 && commandId == m_rawReplyHeader)
+    {
+        return m_rawReplyLength;
+    }
+
+    switch (commandId)
+    {
+    case NEX_RET_EVENT_LAUNCHED:
+        return 1;
+    case NEX_RET_CURRENT_PAGE_ID_HEAD:
+        return 2;
+    case NEX_RET_EVENT_TOUCH_HEAD:
+        return 4;
+    case NEX_RET_NUMBER_HEAD:
+        return 5;
+    case NEX_RET_EVENT_POSITION_HEAD:
+    case NEX_RET_EVENT_SLEEP_POSITION_HEAD:
+        return 6;
+    case NEXTION_VALUE_CHANGE_HEAD:
+    case NEXTION_VALUE_FINAL_HEAD:
+        return 7;
+    default:
+    {
+        INextionChannel *channel = findChannel(commandId);
+        return channel ? channel->getPayloadLength() + 1 : 0;
+    }
+    }
+}
+
+/*!
+ * \brief Calculates the message length in a buffer.
+ * \param buffer Message buffer
+ * \param start Start index
+ * \param length Length of the message (including termination bytes) found
+ * \return True if a message was found.
+ */
+bool Nextion::calcMessageLength(const std::vector<uint8_t> &buffer, std::size_t start,
+                                std::size_t &length) const
+{
+    if (start >= buffer.size())
+    {
+        return false;
+    }
+
+    std::size_t fixedLength = getFixedMessageLength(buffer[start]);
+    std::size_t end = start + fixedLength;
+    if (fixedLength > 0 && end + 3 <= buffer.size() && buffer[end] == 0xFF && buffer[end + 1] == 0xFF &&
+        buffer[end + 2] == 0xFF)
+    {
+        length = fixedLength;
+        return true;
+    }
+
+    for (std::size_t i = start + 2; i < buffer.size(); ++i)
+    {
+        if (buffer[i - 2] == 0xFF && buffer[i - 1] == 0xFF && buffer[i] == 0xFF)
+        {
+            length = i - start - 2;
+            return true;
+        }
+    }
+    return false;
 }
 
 /*!
@@ -114,11 +255,23 @@ void Nextion::readSolicited(
     const std::function<void(const std::vector<uint8_t> &buffer,
                              std::size_t length)> &callback)
 {
-    readMessage(true);
     std::size_t length = 0;
+    if (!calcMessageLength(m_solicitedBuffer, 0, length))
+    {
+        // Messages may have been read ahead, e.g. while waiting for credit
+        readMessage(true);
+    }
     NextionLog("Nextion::readSolicited: Checking for messages. Buffer size: %u\n", m_solicitedBuffer.size());
     if (calcMessageLength(m_solicitedBuffer, 0, length))
     {
+        if (m_replyPending && !m_slowReply)
+        {
+            // Only the first reply after a write tells the latency of the link
+            uint32_t elapsed = micros() - m_lastWriteTime;
+            uint32_t transmit = m_linkMonitor.getTransmitTime(m_lastWriteSize);
+            m_linkMonitor.recordReply(elapsed > transmit ? elapsed - transmit : 0);
+            m_replyPending = false;
+        }
         callback(m_solicitedBuffer, length);
         if (m_solicitedBuffer.size() == length + 3)
         {
@@ -132,6 +285,8 @@ void Nextion::readSolicited(
     else
     {
         NextionLog("Nextion::readSolicited: No message received.\n");
+        m_linkMonitor.recordTimeout();
+        m_replyLate = m_replyPending;
     }
 }
 
@@ -142,11 +297,12 @@ void Nextion::readSolicited(
  */
 void Nextion::readMessage(bool waitForSolicited)
 {
-    if (!waitForSolicited && m_serialPort.available() == 0)
+    if (!waitForSolicited && m_reframeBuffer.empty() && m_serialPort.available() == 0)
     {
         return;
     }
 
+    uint32_t timeout = m_linkMonitor.getTimeout(m_replyPending ? m_lastWriteSize : 0, m_slowReply);
     int read = 0;
     uint64_t startMillis = 0;
     while (true)
@@ -154,26 +310,79 @@ void Nextion::readMessage(bool waitForSolicited)
         startMillis = millis();
         while (true)
         {
+            if (!m_reframeBuffer.empty())
+            {
+                read = m_reframeBuffer.front();
+                m_reframeBuffer.pop_front();
+                break;
+            }
             read = m_serialPort.read();
             if (read >= 0)
             {
                 break;
             }
-            if (millis() - startMillis > m_timeout)
+            // A partial message stays buffered for the next call, so polling
+            // never waits for the rest of it
+            if (!waitForSolicited || millis() - startMillis >= timeout)
             {
                 return;
             }
         }
         m_buffer.push_back(static_cast<uint8_t>(read));
         std::size_t size = m_buffer.size();
-        if (size >= 3 && m_buffer[size - 3] == 0xFF && m_buffer[size - 2] == 0xFF &&
-            m_buffer[size - 1] == 0xFF)
+        if (size == 1)
+        {
+            // Looked up once per message, channels are searched linearly
+            m_messageLength = m_discarding ? 0 : getFixedMessageLength(m_buffer[0]);
+        }
+        if (size < 3 + m_messageLength || m_buffer[size - 3] != 0xFF ||
+            m_buffer[size - 2] != 0xFF || m_buffer[size - 1] != 0xFF)
+        {
+            if (m_messageLength > 0 && size == 3 + m_messageLength)
+            {
+                // No termination where the fixed length puts it, bytes were
+                // lost or garbage was received
+                resync();
+            }
+            else if (size > std::max<std::size_t>(NEXTION_MAX_MESSAGE_LENGTH, m_rawReplyLength + 3))
+            {
+                if (!m_discarding)
+                {
+                    NextionLog("Nextion::readMessage: Message longer than %u bytes dropped\n", NEXTION_MAX_MESSAGE_LENGTH);
+                    ++m_parseErrors;
+                }
+                m_buffer.clear();
+                m_discarding = true;
+            }
+        }
+        else if (m_discarding)
+        {
+            NextionLog("Nextion::readMessage: Resynchronised, %u bytes dropped\n", size);
+            m_buffer.clear();
+            m_discarding = false;
+        }
+        else
         {
             bool isUnsolicited = isMessageUnsolicited(m_buffer[0]);
+            if (isUnsolicited)
+            {
+                m_linkMonitor.recordActivity();
+                // Stamped on arrival, processUnsolicited() may run much later
+                // when a blocking command received the message
+                m_unsolicitedTimestamps.push_back(std::make_pair(m_unsolicitedBuffer.size(), static_cast<uint32_t>(micros())));
+            }
+            else
+            {
+                m_flowControl.acknowledge();
+            }
             std::vector<uint8_t> &targetBuffer = isUnsolicited ? m_unsolicitedBuffer : m_solicitedBuffer;
             targetBuffer.reserve(targetBuffer.size() + size);
             std::copy(m_buffer.cbegin(), m_buffer.cend(), std::back_inserter(targetBuffer));
             m_buffer.clear();
+            if (!isUnsolicited)
+            {
+                limitSolicitedBuffer();
+            }
 
             if (isUnsolicited)
             {
@@ -193,6 +402,56 @@ void Nextion::readMessage(bool waitForSolicited)
     }
 }
 
+/*!
+ * \brief Drops a message whose termination is not where its fixed length puts
+ *        it, up to the first termination received.
+ *
+ * Bytes after that termination are framed again from the start, as they may
+ * hold complete messages of any length. Without a termination all bytes up to
+ * the next one are dropped.
+ */
+void Nextion::resync()
+{
+    ++m_parseErrors;
+    for (std::size_t i = 4; i <= m_buffer.size(); ++i)
+    {
+        if (m_buffer[i - 3] == 0xFF && m_buffer[i - 2] == 0xFF && m_buffer[i - 1] == 0xFF)
+        {
+            NextionLog("Nextion::resync: Broken message of %u bytes dropped: ", i);
+            NextionLogBin(m_buffer, 0, i);
+            m_reframeBuffer.insert(m_reframeBuffer.begin(), m_buffer.begin() + i, m_buffer.end());
+            m_buffer.clear();
+            m_messageLength = 0;
+            return;
+        }
+    }
+
+    NextionLog("Nextion::resync: Dropping bytes until the next termination\n");
+    m_messageLength = 0;
+    m_discarding = true;
+}
+
+/*!
+ * \brief Drops the oldest replies nobody read (e.g. results of commands sent
+ *        without checking them) once NEXTION_SOLICITED_BUFFER_LIMIT is
+ *        exceeded.
+ */
+void Nextion::limitSolicitedBuffer()
+{
+    std::size_t dropped = 0;
+    std::size_t length = 0;
+    while (m_solicitedBuffer.size() - dropped > NEXTION_SOLICITED_BUFFER_LIMIT &&
+           calcMessageLength(m_solicitedBuffer, dropped, length))
+    {
+        dropped += length + 3;
+    }
+    if (dropped > 0)
+    {
+        NextionLog("Nextion::limitSolicitedBuffer: %u bytes of unread replies dropped\n", dropped);
+        m_solicitedBuffer.erase(m_solicitedBuffer.begin(), m_solicitedBuffer.begin() + dropped);
+    }
+}
+
 /*!
  * \brief Processes unsolicited messages from unsolicited message buffer.
  */
@@ -200,8 +459,15 @@ void Nextion::processUnsolicited()
 {
     std::size_t start = 0;
     std::size_t length = 0;
+    std::size_t message = 0;
     while (calcMessageLength(m_unsolicitedBuffer, start, length))
     {
+        while (message + 1 < m_unsolicitedTimestamps.size() && m_unsolicitedTimestamps[message + 1].first <= start)
+        {
+            ++message;
+        }
+        uint32_t timestamp = m_unsolicitedTimestamps.empty() ? micros() : m_unsolicitedTimestamps[message].second;
+
         switch (m_unsolicitedBuffer[start])
         {
         case NEX_RET_EVENT_TOUCH_HEAD:
@@ -217,19 +483,82 @@ void Nextion::processUnsolicited()
                            m_unsolicitedBuffer[start + 2],
                            m_unsolicitedBuffer[start + 3]);
 
-                for (auto iter = m_touchableList.cbegin(); iter != m_touchableList.cend(); ++iter)
+                NextionTouchEvent event;
+                event.kind = NEX_EVENT_KIND_TOUCH;
+                event.pageID = m_unsolicitedBuffer[start + 1];
+                event.componentID = m_unsolicitedBuffer[start + 2];
+                event.eventType = m_unsolicitedBuffer[start + 3];
+                event.value = 0;
+                event.timestamp = timestamp;
+                if (!m_deferEvents)
                 {
-                    if ((*iter)->processEvent(m_unsolicitedBuffer[start + 1],
-                                              m_unsolicitedBuffer[start + 2],
-                                              m_unsolicitedBuffer[start + 3]))
-                    {
-                        NextionLog("Nextion::processUnsolicited: NEX_RET_EVENT_TOUCH_HEAD was handled by: %s\n", (*iter)->getName().c_str());
-                    }
+                    dispatchTouchEvent(event);
+                }
+                else if (!m_eventQueue.push(event))
+                {
+                    ++m_eventOverflows;
+                    NextionLog("Nextion::processUnsolicited: Event queue full, NEX_RET_EVENT_TOUCH_HEAD dropped.\n");
                 }
-                NextionLog("Nextion::processUnsolicited: NEX_RET_EVENT_TOUCH_HEAD processing completed");
             }
             break;
 
+        case NEXTION_VALUE_CHANGE_HEAD:
+        case NEXTION_VALUE_FINAL_HEAD:
+            if (length != 7)
+            {
+                NextionLog("Nextion::processUnsolicited: NEXTION_VALUE_CHANGE_HEAD did "
+                           "not get all the data.\n");
+            }
+            else
+            {
+                NextionTouchEvent event;
+                event.kind = m_unsolicitedBuffer[start] == NEXTION_VALUE_FINAL_HEAD ? NEX_EVENT_KIND_FINAL_VALUE
+                                                                                   : NEX_EVENT_KIND_VALUE;
+                event.pageID = m_unsolicitedBuffer[start + 1];
+                event.componentID = m_unsolicitedBuffer[start + 2];
+                event.eventType = 0;
+                event.value = ((uint32_t)m_unsolicitedBuffer[start + 6] << 24) |
+                              ((uint32_t)m_unsolicitedBuffer[start + 5] << 16) |
+                              ((uint32_t)m_unsolicitedBuffer[start + 4] << 8) |
+                              (m_unsolicitedBuffer[start + 3]);
+                event.timestamp = timestamp;
+                NextionLog("Nextion::processUnsolicited: NEXTION_VALUE_CHANGE_HEAD for pageID: %u, componentID: %u, value: %u\n",
+                           event.pageID, event.componentID, event.value);
+
+                if (!m_deferEvents)
+                {
+                    dispatchValueChange(event);
+                }
+                else if (!m_eventQueue.push(event))
+                {
+                    ++m_eventOverflows;
+                    NextionLog("Nextion::processUnsolicited: Event queue full, NEXTION_VALUE_CHANGE_HEAD dropped.\n");
+                }
+            }
+            break;
+
+        case NEX_RET_CURRENT_PAGE_ID_HEAD:
+            if (length != 2)
+            {
+                NextionLog("Nextion::processUnsolicited: NEX_RET_CURRENT_PAGE_ID_HEAD did "
+                           "not get all the data.\n");
+            }
+            else
+            {
+                NextionLog("Nextion::processUnsolicited: NEX_RET_CURRENT_PAGE_ID_HEAD, page %u loaded.\n",
+                           m_unsolicitedBuffer[start + 1]);
+                if (m_unsolicitedBuffer[start + 1] != m_currentPage)
+                {
+                    notifyPageChanged(m_unsolicitedBuffer[start + 1]);
+                }
+            }
+            break;
+
+        case NEX_RET_EVENT_LAUNCHED:
+            NextionLog("Nextion::processUnsolicited: NEX_RET_EVENT_LAUNCHED, device restarted.\n");
+            m_recoveryPending = true;
+            break;
+
         case NEX_RET_EVENT_POSITION_HEAD:
             NextionLog("Nextion::processUnsolicited: NEX_RET_EVENT_POSITION_HEAD not "
                        "implemented.\n");
@@ -241,15 +570,24 @@ void Nextion::processUnsolicited()
             break;
 
         default:
+        {
+            INextionChannel *channel = findChannel(m_unsolicitedBuffer[start]);
+            if (channel && length == channel->getPayloadLength() + 1)
+            {
+                channel->processMessage(&m_unsolicitedBuffer[start + 1], length - 1);
+                break;
+            }
             NextionLog("Nextion::processUnsolicited: Message not implemented: ");
             NextionLogBin(m_unsolicitedBuffer, start, length);
             break;
         }
+        }
 
         start += length + 3;
     }
 
     m_unsolicitedBuffer.clear();
+    m_unsolicitedTimestamps.clear();
 }
 
 /*!
@@ -283,6 +621,86 @@ bool Nextion::refresh(const String &objectName)
     return checkCommandComplete();
 }
 
+/*!
+ * \brief Requests an object to be refreshed.
+ * \param objectName Name of the object to refresh
+ * \return True if successful
+ *
+ * Refreshes immediately, unless refreshes are deferred, in which case the
+ * object is marked dirty and refreshed by the next Nextion::flushRefresh().
+ */
+bool Nextion::requestRefresh(const String &objectName)
+{
+    if (!m_deferRefresh)
+    {
+        return refresh(objectName);
+    }
+
+    if (std::find(m_dirtyObjects.cbegin(), m_dirtyObjects.cend(), objectName) == m_dirtyObjects.cend())
+    {
+        m_dirtyObjects.push_back(objectName);
+    }
+    return true;
+}
+
+/*!
+ * \brief Refreshes all objects marked dirty by Nextion::requestRefresh().
+ * \return True if successful
+ *
+ * Issues one refresh per dirty object, or a single refresh of the entire page
+ * once the number of dirty objects reaches the threshold.
+ */
+bool Nextion::flushRefresh()
+{
+    if (m_dirtyObjects.empty())
+    {
+        return true;
+    }
+
+    bool result = true;
+    if (m_refreshAllThreshold > 0 && m_dirtyObjects.size() >= m_refreshAllThreshold)
+    {
+        result = refresh();
+    }
+    else
+    {
+        for (auto iter = m_dirtyObjects.cbegin(); iter != m_dirtyObjects.cend(); ++iter)
+        {
+            result &= refresh(*iter);
+        }
+    }
+    m_dirtyObjects.clear();
+    return result;
+}
+
+/*!
+ * \brief Sets whether refreshes requested after a property change are
+ *        collected and issued together by Nextion::flushRefresh().
+ * \param deferred If refreshes should be deferred
+ * \param refreshAllThreshold Number of dirty objects from which the entire
+ *                            page is refreshed instead, 0 to never do so
+ *
+ * Nextion::poll() flushes deferred refreshes.
+ */
+void Nextion::setDeferredRefresh(bool deferred, size_t refreshAllThreshold)
+{
+    if (!deferred)
+    {
+        flushRefresh();
+    }
+    m_deferRefresh = deferred;
+    m_refreshAllThreshold = refreshAllThreshold;
+}
+
+/*!
+ * \brief Checks whether refreshes are deferred.
+ * \return True if deferred
+ */
+bool Nextion::isRefreshDeferred() const
+{
+    return m_deferRefresh;
+}
+
 /*!
  * \brief Puts the device into sleep mode.
  * \return True if successful
@@ -330,11 +748,11 @@ bool Nextion::setBrightness(uint16_t brightness, bool persist)
 {
     if (persist)
     {
-        sendCommand("dims=%d", brightness);
+        sendCommand(String("dims=") + String(brightness));
     }
     else
     {
-        sendCommand("dim=%d", brightness);
+        sendCommand(String("dim=") + String(brightness));
     }
     return checkCommandComplete();
 }
@@ -346,13 +764,20 @@ bool Nextion::setBrightness(uint16_t brightness, bool persist)
  */
 bool Nextion::getCurrentPage(uint8_t &id)
 {
+    // The page ID is a reply only while it is asked for, otherwise the device
+    // reports a page change (sendme in the page's preinit event)
+    m_pageRequested = true;
     sendCommand("sendme");
     bool result = false;
     bool exit = false;
     while (!exit)
     {
+        // A timed out read does not call back
+        exit = true;
+        result = false;
         readSolicited(
             [this, &id, &result, &exit](const std::vector<uint8_t> &buffer, std::size_t length) {
+                exit = false;
                 if (length == 0)
                 {
                     NextionLog("Nextion::getCurrentPage: Reading response timed out.\n");
@@ -360,7 +785,7 @@ bool Nextion::getCurrentPage(uint8_t &id)
                 }
                 else if (length == 1)
                 {
-                    result = checkCommandCompleteIntrn(buffer, length);
+                    result = checkCommandCompleteIntrn(buffer, length).isSuccess();
                     if (!result)
                     {
                         exit = true;
@@ -383,9 +808,43 @@ bool Nextion::getCurrentPage(uint8_t &id)
                 }
             });
     }
+    m_pageRequested = false;
+    if (result && id != m_currentPage)
+    {
+        notifyPageChanged(id);
+    }
     return result;
 }
 
+/*!
+ * \brief Gets the ID of the page last known to be displayed, without asking
+ *        the device.
+ * \return Page ID
+ * \see Nextion::getCurrentPage
+ */
+uint8_t Nextion::getCurrentPageID() const
+{
+    return m_currentPage;
+}
+
+/*!
+ * \brief Records that a page is now displayed and informs the registered page
+ *        listeners.
+ * \param id ID of the page now displayed
+ *
+ * Called automatically by NextionPage::show, Nextion::getCurrentPage and
+ * when the device reports the page it loaded, i.e. pages running sendme in
+ * their preinit event.
+ */
+void Nextion::notifyPageChanged(uint8_t id)
+{
+    m_currentPage = id;
+    for (auto iter = m_pageListenerList.cbegin(); iter != m_pageListenerList.cend(); ++iter)
+    {
+        (*iter)->pageChanged(id);
+    }
+}
+
 /*!
  * \brief Clears the current display.
  * \param colour Colour to set display to
@@ -393,7 +852,7 @@ bool Nextion::getCurrentPage(uint8_t &id)
  */
 bool Nextion::clear(uint32_t colour)
 {
-    sendCommand("cls %d", colour);
+    sendCommand(String("cls ") + String(colour));
     return checkCommandComplete();
 }
 
@@ -446,18 +905,8 @@ bool Nextion::drawStr(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
                       NextionFontAlignment xCentre,
                       NextionFontAlignment yCentre)
 {
-    if (str.indexOf('\"') >= 0)
-    {
-        String strEscaped(str);
-        strEscaped.replace("\"", "\\\"");
-        sendCommand("xstr %d,%d,%d,%d,%d,%d,%d,%d,%d,%d,\"%s\"", x, y, w, h, fontID,
-                    fgColour, bgColour, xCentre, yCentre, bgType, strEscaped.c_str());
-    }
-    else
-    {
-        sendCommand("xstr %d,%d,%d,%d,%d,%d,%d,%d,%d,%d,\"%s\"", x, y, w, h, fontID,
-                    fgColour, bgColour, xCentre, yCentre, bgType, str.c_str());
-    }
+    sendCommandWithString(str, "xstr %d,%d,%d,%d,%d,%d,%d,%d,%d,%d,", x, y, w, h, fontID,
+                          fgColour, bgColour, xCentre, yCentre, bgType);
     return checkCommandComplete();
 }
 
@@ -491,11 +940,11 @@ bool Nextion::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool fill
 {
     if (filled)
     {
-        sendCommand("draw %d,%d,%d,%d,%d", x, y, x + w, y + h, colour);
+        sendCommand("fill %d,%d,%d,%d,%d", x, y, w, h, colour);
     }
     else
     {
-        sendCommand("fill %d,%d,%d,%d,%d", x, y, x + w, y + h, colour);
+        sendCommand("draw %d,%d,%d,%d,%d", x, y, x + w, y + h, colour);
     }
     return checkCommandComplete();
 }
@@ -548,6 +997,103 @@ void Nextion::unregisterTouchable(INextionTouchable *touchable)
     m_touchableList.remove(touchable);
 }
 
+/*!
+ * \brief Adds a NextionValueSubscription to the list of subscriptions
+ *        receiving value change notifications.
+ * \param subscription Pointer to the NextionValueSubscription
+ *
+ * Should be called automatically by the NextionValueSubscription constructor.
+ */
+void Nextion::registerValueSubscription(NextionValueSubscription *subscription)
+{
+    m_valueSubscriptionList.push_front(subscription);
+}
+
+/*!
+ * \brief Removes a NextionValueSubscription from the list of subscriptions.
+ * \param subscription Pointer to the NextionValueSubscription
+ *
+ * Should be called automatically by
+ * NextionValueSubscription::~NextionValueSubscription.
+ */
+void Nextion::unregisterValueSubscription(NextionValueSubscription *subscription)
+{
+    m_valueSubscriptionList.remove(subscription);
+}
+
+/*!
+ * \brief Registers a channel for custom unsolicited messages.
+ * \param channel Pointer to the INextionChannel, must outlive the registration
+ * \return True if successful, false if the header is used by the device, the
+ *         packed replies of NextionBulkRead or another channel
+ */
+bool Nextion::registerChannel(INextionChannel *channel)
+{
+    uint8_t header = channel->getHeader();
+    bool reserved = header <= NEX_RET_SERIAL_BUFFER_OVERFLOW ||
+                    (header >= NEX_RET_EVENT_TOUCH_HEAD && header <= NEX_RET_NUMBER_HEAD) ||
+                    (header >= NEX_RET_EVENT_AUTO_SLEEP && header <= NEX_RET_EVENT_UPGRADED) ||
+                    header >= NEX_RET_EVENT_TRANSPARENT_DATA_FINISHED || header == NEXTION_VALUE_CHANGE_HEAD ||
+                    header == NEXTION_VALUE_FINAL_HEAD || header == NEXTION_BULK_READ_HEAD;
+    if (reserved || findChannel(header))
+    {
+        NextionLog("Nextion::registerChannel: Header 0x%02X is already in use\n", header);
+        return false;
+    }
+
+    m_channelList.push_front(channel);
+    return true;
+}
+
+/*!
+ * \brief Removes a channel registered with registerChannel().
+ * \param channel Pointer to the INextionChannel
+ */
+void Nextion::unregisterChannel(INextionChannel *channel)
+{
+    m_channelList.remove(channel);
+}
+
+/*!
+ * \brief Adds a INextionPageListener to the list of objects informed about
+ *        page changes.
+ * \param listener Pointer to the INextionPageListener
+ */
+void Nextion::registerPageListener(INextionPageListener *listener)
+{
+    m_pageListenerList.push_front(listener);
+}
+
+/*!
+ * \brief Removes a INextionPageListener from the list of objects informed
+ *        about page changes.
+ * \param listener Pointer to the INextionPageListener
+ */
+void Nextion::unregisterPageListener(INextionPageListener *listener)
+{
+    m_pageListenerList.remove(listener);
+}
+
+/*!
+ * \brief Adds a INextionPollListener to the list of objects called on every
+ *        poll.
+ * \param listener Pointer to the INextionPollListener
+ */
+void Nextion::registerPollListener(INextionPollListener *listener)
+{
+    m_pollListenerList.push_front(listener);
+}
+
+/*!
+ * \brief Removes a INextionPollListener from the list of objects called on
+ *        every poll.
+ * \param listener Pointer to the INextionPollListener
+ */
+void Nextion::unregisterPollListener(INextionPollListener *listener)
+{
+    m_pollListenerList.remove(listener);
+}
+
 /*!
  * \brief Sends a command to the device.
  * \param command Command to send
@@ -558,10 +1104,21 @@ void Nextion::sendCommand(const char *command, std::size_t commandSize)
     NextionLog("Nextion::sendCommand: Sending %u bytes -> ", commandSize);
     NextionLogStr(command, 0, commandSize);
 
+    dropLateReply();
+    pace();
+    waitForCredit(commandSize + 3);
     m_serialPort.write(command, commandSize);
     m_serialPort.write(0xFF);
     m_serialPort.write(0xFF);
     m_serialPort.write(0xFF);
+    m_flowControl.sent(commandSize + 3);
+    recordWrite(commandSize + 3, isSlowCommand(reinterpret_cast<const uint8_t *>(command), commandSize));
+
+    if (m_retryPolicy.maxAttempts > 1)
+    {
+        m_lastCommand.clear();
+        m_lastCommand.add(command, commandSize);
+    }
 }
 
 /*!
@@ -583,119 +1140,503 @@ void Nextion::sendCommand(const char *format, ...)
 
 void Nextion::sendCommand(const char *format, va_list args)
 {
+    int written = formatCommand(format, args);
+    if (written >= 0)
+    {
+        sendCommand(&m_printBuffer[0], written);
+    }
+}
+
+/*!
+ * \brief Sends a command ending in a quoted string, e.g.
+ *        sendCommandWithString(text, "t0.txt=").
+ * \param str Text of the string, escaped while it is written
+ * \param format Format string of the part before the string
+ *
+ * Only the part before the string goes through the print buffer, the text
+ * itself is written straight to the serial port, so long strings do not grow
+ * the buffer.
+ */
+void Nextion::sendCommandWithString(const String &str, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = formatCommand(format, args);
+    va_end(args);
+    if (written < 0)
+    {
+        return;
+    }
+
+    NextionLog("Nextion::sendCommandWithString: Sending %u + %u bytes -> ", written, str.length());
+    NextionLogStr(&m_printBuffer[0], 0, written);
+    NextionLogStr(str.c_str(), 0, str.length());
+
+    size_t size = written + NextionEscape::escapedLength(str.c_str(), str.length()) + 5;
+    dropLateReply();
+    pace();
+    waitForCredit(size);
+    m_serialPort.write(&m_printBuffer[0], written);
+    m_serialPort.write('\"');
+    NextionEscape::write(m_serialPort, str.c_str(), str.length());
+    m_serialPort.write('\"');
+    m_serialPort.write(0xFF);
+    m_serialPort.write(0xFF);
+    m_serialPort.write(0xFF);
+    m_flowControl.sent(size);
+    recordWrite(size, isSlowCommand(reinterpret_cast<const uint8_t *>(&m_printBuffer[0]), written));
+
+    if (m_retryPolicy.maxAttempts > 1)
+    {
+        m_lastCommand.clear();
+        m_lastCommand.addWithString(str, "%.*s", written, &m_printBuffer[0]);
+    }
+}
+
+/*!
+ * \brief Formats a command into the print buffer, growing it if needed.
+ * \param format Format string
+ * \param args Format arguments
+ * \return Length of the formatted command, negative on failure
+ */
+int Nextion::formatCommand(const char *format, va_list args)
+{
+    va_list argsCopy;
+    va_copy(argsCopy, args);
     int written = vsnprintf(&m_printBuffer[0], m_printBuffer.size(), format, args);
-    if(written < 0)
+    if (written < 0)
+    {
+        NextionLog("Nextion::formatCommand: Failed to format the string");
+    }
+    else if (static_cast<size_t>(written) >= m_printBuffer.size())
+    {
+        m_printBuffer.resize(written + 1);
+        vsnprintf(&m_printBuffer[0], m_printBuffer.size(), format, argsCopy);
+    }
+    va_end(argsCopy);
+    return written;
+}
+
+/*!
+ * \brief Sends all commands of a batch in a single write, then waits for all
+ *        their results.
+ * \param batch Commands to send
+ * \return True if all commands were successful
+ *
+ * Commands failing with a transient result are sent again as allowed by the
+ * retry policy, in one write per attempt.
+ */
+bool Nextion::sendBatch(const NextionCommandBatch &batch)
+{
+    if (batch.getCommandCount() == 0)
     {
-        NextionLog("Nextion::sendCommand: Failed to format the string");
+        return true;
     }
-    else 
+
+    writeBatch(batch);
+
+    if (!m_commandResultRequired)
     {
-        if (written >= m_printBuffer.size())
+        return true;
+    }
+
+    bool result = true;
+    NextionCommandBatch retry(0);
+    readBatchResults(batch, result, retry);
+
+    uint32_t backoff = m_retryPolicy.initialBackoff;
+    for (uint8_t attempt = 1; attempt < m_retryPolicy.maxAttempts && retry.getCommandCount() > 0; ++attempt)
+    {
+        NextionLog("Nextion::sendBatch: Retrying %u commands\n", retry.getCommandCount());
+        waitBeforeRetry(backoff);
+        m_retries += retry.getCommandCount();
+        NextionCommandBatch failed(0);
+        writeBatch(retry);
+        readBatchResults(retry, result, failed);
+        retry = std::move(failed);
+    }
+
+    return result && retry.getCommandCount() == 0;
+}
+
+/*!
+ * \brief Reads the results of all commands of a batch.
+ * \param batch Commands sent
+ * \param result Cleared if a command failed and will not be retried
+ * \param retry Receives the commands that should be retried
+ *
+ * Once a result times out the remaining ones fail without waiting for them.
+ */
+void Nextion::readBatchResults(const NextionCommandBatch &batch, bool &result, NextionCommandBatch &retry)
+{
+    bool timedOut = false;
+    size_t offset = 0;
+    for (size_t i = 0; i < batch.getCommandCount(); ++i)
+    {
+        // Walked once alongside the results, the commands are only needed
+        // for retries
+        const uint8_t *command = nullptr;
+        size_t length = 0;
+        bool found = batch.getNextCommand(offset, command, length);
+
+        NextionResult commandResult = NextionResult::timeout();
+        if (!timedOut)
+        {
+            commandResult = readCommandResult();
+            if (commandResult.isTimeout())
+            {
+                NextionLog("Nextion::sendBatch: Result %u of %u not received.\n", i + 1, batch.getCommandCount());
+                timedOut = true;
+            }
+        }
+        if (commandResult.isSuccess())
         {
-            m_printBuffer.resize(written + 1);
-            vsnprintf(&m_printBuffer[0], m_printBuffer.size(), format, args);
+            continue;
         }
 
-        sendCommand(&m_printBuffer[0], written);
+        if (m_retryPolicy.maxAttempts > 1 && isRetryable(commandResult) && found)
+        {
+            retry.add(reinterpret_cast<const char *>(command), length);
+        }
+        else
+        {
+            result = false;
+        }
     }
 }
 
 /*!
- * \brief Checks if the last command was successful.
- * \return True if command was successful
+ * \brief Sends all commands of a batch in a single write without waiting for
+ *        any results.
+ * \param batch Commands to send
+ *
+ * The caller is responsible for reading the replies, e.g. with
+ * receiveNumbers(). A batch that does not fit into the input buffer of the
+ * device is split into several writes, waiting for credit in between (see
+ * NextionFlowControl).
  */
-bool Nextion::checkCommandCompleteIntrn(const std::vector<uint8_t> &buffer, std::size_t length)
+void Nextion::writeBatch(const NextionCommandBatch &batch)
 {
-    if (length == 0)
+    if (batch.getCommandCount() == 0)
     {
-        NextionLog("Nextion::checkCommandComplete: Reading response timed out.\n");
-        return false;
+        return;
     }
-    switch (buffer[0])
+
+    NextionLog("Nextion::writeBatch: Sending %u commands, %u bytes\n", batch.getCommandCount(), batch.getSize());
+    dropLateReply();
+    pace();
+
+    const uint8_t *data = batch.getData();
+    size_t size = batch.getSize();
+    size_t chunkStart = 0;
+    size_t commandStart = 0;
+    for (size_t i = 0; i + 2 < size; ++i)
+    {
+        if (data[i] != 0xFF || data[i + 1] != 0xFF || data[i + 2] != 0xFF)
+        {
+            continue;
+        }
+
+        size_t commandSize = i + 3 - commandStart;
+        if (!m_flowControl.canSend(commandSize))
+        {
+            // Credit only returns for commands that were written
+            if (commandStart > chunkStart)
+            {
+                m_serialPort.write(data + chunkStart, commandStart - chunkStart);
+                chunkStart = commandStart;
+            }
+            waitForCredit(commandSize);
+        }
+        m_flowControl.sent(commandSize);
+        commandStart = i + 3;
+        i += 2;
+    }
+    if (size > chunkStart)
+    {
+        m_serialPort.write(data + chunkStart, size - chunkStart);
+    }
+
+    bool slow = false;
+    size_t offset = 0;
+    const uint8_t *command = NULL;
+    size_t length = 0;
+    while (!slow && batch.getNextCommand(offset, command, length))
+    {
+        slow = isSlowCommand(command, length);
+    }
+    recordWrite(size, slow);
+    m_lastCommand.clear();
+}
+
+/*!
+ * \brief Interprets a command result read from the device.
+ * \param buffer Message buffer
+ * \param length Length of the message, 0 if it was not received
+ * \return Result
+ */
+NextionResult Nextion::checkCommandCompleteIntrn(const std::vector<uint8_t> &buffer, std::size_t length)
+{
+    NextionResult result = length == 0 ? NextionResult::timeout() : NextionResult(static_cast<NextionValue>(buffer[0]));
+    if (result.isSuccess())
     {
-    case NEX_RET_CMD_FAILED:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_CMD_FAILED\n");
-        return false;
-    case NEX_RET_CMD_FINISHED:
         NextionLog("Nextion::checkCommandComplete: OK\n");
-        return true;
-    case NEX_RET_INVALID_COMPONENT_ID:
-        NextionLog(
-            "Nextion::checkCommandComplete: NEX_RET_INVALID_COMPONENT_ID\n");
-        return false;
-    case NEX_RET_INVALID_PAGE_ID:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_PAGE_ID\n");
-        return false;
-    case NEX_RET_INVALID_PICTURE_ID:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_PICTURE_ID\n");
-        return false;
-    case NEX_RET_INVALID_FONT_ID:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_FONT_ID\n");
-        return false;
-    case NEX_RET_INVALID_FILE_OP:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_FILE_OP\n");
-        return false;
-    case NEX_RET_INVALID_CRC:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_CRC\n");
-        return false;
-    case NEX_RET_INVALID_BAUD:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_BAUD\n");
-        return false;
-    case NEX_RET_INVALID_WAVEFORM_ID_CHANNEL:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_WAVEFORM_ID_CHANNEL\n");
-        return false;
-    case NEX_RET_INVALID_VARIABLE:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_VARIABLE\n");
-        return false;
-    case NEX_RET_INVALID_OPERATION:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_OPERATION\n");
-        return false;
-    case NEX_RET_FAILED_TO_ASSIGN:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_FAILED_TO_ASSIGN\n");
-        return false;
-    case NEX_RET_EEPROM_OP_FAILED:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_EEPROM_OP_FAILED\n");
-        return false;
-    case NEX_RET_INVALID_NUM_PARAMS:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_NUM_PARAMS\n");
-        return false;
-    case NEX_RET_IO_OP_FAILED:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_IO_OP_FAILED\n");
-        return false;
-    case NEX_RET_INVALID_ESCAPE_CHAR:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_INVALID_ESCAPE_CHAR\n");
-        return false;
-    case NEX_RET_VAR_NAME_TOO_LONG:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_VAR_NAME_TOO_LONG\n");
-        return false;
-    case NEX_RET_SERIAL_BUFFER_OVERFLOW:
-        NextionLog("Nextion::checkCommandComplete: NEX_RET_SERIAL_BUFFER_OVERFLOW\n");
-        return false;
-    default:
-        NextionLog("Nextion::checkCommandComplete: Unexpected response: 0x%x\n",
-                   buffer[0]);
-        return false;
     }
+    else if (result.isTimeout())
+    {
+        NextionLog("Nextion::checkCommandComplete: Reading response timed out.\n");
+    }
+    else
+    {
+        NextionLog("Nextion::checkCommandComplete: %s (0x%x)\n", result.getName(), buffer[0]);
+    }
+    recordResult(result);
+    return result;
+}
+
+/*!
+ * \brief Reads the result of a command.
+ * \return Result, a timeout if none was received
+ */
+NextionResult Nextion::readCommandResult()
+{
+    NextionResult result = NextionResult::timeout();
+    bool received = false;
+    readSolicited([this, &result, &received](const std::vector<uint8_t> &buffer, std::size_t length) {
+        received = true;
+        result = checkCommandCompleteIntrn(buffer, length);
+    });
+    if (!received)
+    {
+        recordResult(result);
+    }
+    return result;
 }
 
 /*!
  * \brief Checks if the last command was successful.
  * \param overrideRequireCommandResult Indicates whether persisted command result requirement should be ignored
  * \return True if command was successful
+ * \see Nextion::getCommandResult
  */
 bool Nextion::checkCommandComplete(bool overrideRequireCommandResult /*= false*/)
+{
+    return getCommandResult(overrideRequireCommandResult).isSuccess();
+}
+
+/*!
+ * \brief Gets the result of the last command, sending it again as allowed by
+ *        the retry policy while it fails with a transient result.
+ * \param overrideRequireCommandResult Indicates whether persisted command result requirement should be ignored
+ * \return Result, success if results are not required
+ */
+NextionResult Nextion::getCommandResult(bool overrideRequireCommandResult /*= false*/)
 {
     if (!overrideRequireCommandResult && !m_commandResultRequired)
     {
-        return true;
+        return NextionResult();
     }
 
-    bool result = false;
-    readSolicited([this, &result](const std::vector<uint8_t> &buffer, std::size_t length) {
-        result = checkCommandCompleteIntrn(buffer, length);
-    });
+    NextionResult result = readCommandResult();
+    uint32_t backoff = m_retryPolicy.initialBackoff;
+    for (uint8_t attempt = 1; attempt < m_retryPolicy.maxAttempts && !result.isSuccess() && isRetryable(result) &&
+                              m_lastCommand.getCommandCount() > 0;
+         ++attempt)
+    {
+        NextionLog("Nextion::getCommandResult: %s, retrying\n", result.getName());
+        waitBeforeRetry(backoff);
+        ++m_retries;
+        dropLateReply();
+        pace();
+        waitForCredit(m_lastCommand.getSize());
+        m_serialPort.write(m_lastCommand.getData(), m_lastCommand.getSize());
+        m_flowControl.sent(m_lastCommand.getSize());
+        recordWrite(m_lastCommand.getSize(), isSlowCommand(m_lastCommand.getData(), m_lastCommand.getSize()));
+        result = readCommandResult();
+    }
+    return result;
+}
+
+/*!
+ * \brief Gets the last command result read from the device.
+ * \return Result
+ */
+NextionResult Nextion::getLastResult() const
+{
+    return m_lastResult;
+}
+
+/*!
+ * \brief Sets how commands failing with a transient result are retried.
+ * \param policy Retry policy
+ *
+ * While retries are enabled the last command is kept so it can be sent again.
+ */
+void Nextion::setRetryPolicy(const NextionRetryPolicy &policy)
+{
+    m_retryPolicy = policy;
+    m_lastCommand.clear();
+    if (m_retryPolicy.throttleStep == 0)
+    {
+        m_throttle = 0;
+    }
+}
+
+/*!
+ * \brief Gets how commands failing with a transient result are retried.
+ * \return Retry policy
+ */
+const NextionRetryPolicy &Nextion::getRetryPolicy() const
+{
+    return m_retryPolicy;
+}
+
+/*!
+ * \brief Gets the number of commands sent again after a transient failure.
+ * \return Number of retries
+ */
+uint32_t Nextion::getRetryCount() const
+{
+    return m_retries;
+}
+
+/*!
+ * \brief Gets the gap currently kept between writes because of buffer
+ *        overflows.
+ * \return Gap in us
+ */
+uint32_t Nextion::getThrottle() const
+{
+    return m_throttle;
+}
+
+/*!
+ * \brief Gets the model of the input buffer of the device writes are paced
+ *        by.
+ * \return Flow control
+ */
+NextionFlowControl &Nextion::getFlowControl()
+{
+    return m_flowControl;
+}
+
+/*!
+ * \brief Gets the number of broken messages dropped by the receive parser,
+ *        e.g. because bytes were lost.
+ * \return Number of messages
+ */
+uint32_t Nextion::getParseErrorCount() const
+{
+    return m_parseErrors;
+}
+
+/*!
+ * \brief Checks if the retry policy allows a failed command to be sent again.
+ * \param result Result of the command
+ * \return True if it may be retried
+ */
+bool Nextion::isRetryable(const NextionResult &result) const
+{
+    if (!result.isTransient())
+    {
+        return false;
+    }
+    // A dead link fails fast, retrying would only add the backoff
+    return !result.isTimeout() || (m_retryPolicy.retryOnTimeout && m_linkMonitor.isAlive());
+}
+
+/*!
+ * \brief Waits before a retry and drops replies arriving late for the failed
+ *        attempt, so they are not taken as results of the retry.
+ * \param backoff Wait in ms, grown for the next retry
+ */
+void Nextion::waitBeforeRetry(uint32_t &backoff)
+{
+    delay(backoff);
+    backoff = std::min(backoff * m_retryPolicy.backoffFactor, m_retryPolicy.maxBackoff);
+
+    while (m_serialPort.available() > 0)
+    {
+        readMessage(false);
+    }
+    if (!m_solicitedBuffer.empty())
+    {
+        // Any late reply was among the dropped ones
+        m_replyLate = false;
+    }
+    m_solicitedBuffer.clear();
+}
+
+/*!
+ * \brief Records a command result and adapts the gap between writes.
+ * \param result Result
+ */
+void Nextion::recordResult(const NextionResult &result)
+{
+    m_lastResult = result;
+    if (!result.isTimeout() && result.getCode() == NEX_RET_SERIAL_BUFFER_OVERFLOW && m_retryPolicy.throttleStep > 0)
+    {
+        m_throttle = std::min(m_throttle + m_retryPolicy.throttleStep, m_retryPolicy.maxThrottle);
+        NextionLog("Nextion::recordResult: Buffer overflow, throttling to %u us between writes\n", m_throttle);
+    }
+    else if (result.isSuccess())
+    {
+        m_throttle -= (m_throttle + 7) / 8;
+    }
+}
+
+/*!
+ * \brief Waits until a command fits into the input buffer of the device.
+ * \param size Size of the command (including termination bytes)
+ *
+ * When commands are acknowledged replies are read into the solicited buffer,
+ * where they stay for their callers. If no reply arrives the buffer is
+ * assumed to be empty.
+ */
+void Nextion::waitForCredit(std::size_t size)
+{
+    if (m_flowControl.canSend(size))
+    {
+        return;
+    }
+
+    m_flowControl.recordStall();
+    NextionLog("Nextion::waitForCredit: %u bytes outstanding, waiting\n", m_flowControl.getOutstanding());
+    while (!m_flowControl.canSend(size))
+    {
+        if (m_flowControl.isAcknowledged())
+        {
+            std::size_t buffered = m_solicitedBuffer.size();
+            readMessage(true);
+            if (m_solicitedBuffer.size() == buffered)
+            {
+                m_flowControl.reset();
+            }
+        }
+        else
+        {
+            uint32_t wait = m_flowControl.getWaitTime(size);
+            delay(wait / 1000);
+            delayMicroseconds(wait % 1000);
+        }
+    }
+}
+
+/*!
+ * \brief Waits until the gap kept between writes has passed.
+ */
+void Nextion::pace()
+{
+    if (m_throttle == 0)
+    {
+        return;
+    }
 
-    return result;
+    uint32_t elapsed = micros() - m_lastWriteTime;
+    if (elapsed < m_throttle)
+    {
+        delayMicroseconds(m_throttle - elapsed);
+    }
 }
 
 /*!
@@ -726,6 +1667,136 @@ bool Nextion::receiveNumber(uint32_t &number)
     return result;
 }
 
+/*!
+ * \brief Receives the replies of several pipelined number requests, in the
+ *        order they were sent.
+ * \param values Array receiving the values
+ * \param status Array receiving 1 if each value was received and 0
+ *               otherwise, may be null
+ * \param count Number of replies to read
+ * \return Number of values received
+ *
+ * A reply that is not a number (e.g. the error for an invalid variable) only
+ * fails its own item. Once a reply times out the remaining items fail, and
+ * replies still arriving for them are discarded, since they can no longer be
+ * matched to their requests.
+ */
+size_t Nextion::receiveNumbers(uint32_t *values, uint8_t *status, size_t count)
+{
+    size_t received = 0;
+    bool timedOut = false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        bool result = false;
+        if (!timedOut)
+        {
+            bool replied = false;
+            readSolicited([&result, &replied, values, i](const std::vector<uint8_t> &buffer, std::size_t length) {
+                replied = true;
+                if (length == 5 && buffer[0] == NEX_RET_NUMBER_HEAD)
+                {
+                    values[i] = ((uint32_t)buffer[4] << 24) | ((uint32_t)buffer[3] << 16) | ((uint32_t)buffer[2] << 8) | (buffer[1]);
+                    result = true;
+                }
+                else
+                {
+                    NextionLog("Nextion::receiveNumbers: Unexpected response for item %u: 0x%02X\n", i, buffer[0]);
+                }
+            });
+            if (!replied)
+            {
+                NextionLog("Nextion::receiveNumbers: Reply %u of %u not received.\n", i + 1, count);
+                timedOut = true;
+                discardLateReplies(count - i);
+            }
+        }
+
+        if (status)
+        {
+            status[i] = result;
+        }
+        if (result)
+        {
+            ++received;
+        }
+    }
+    return received;
+}
+
+/*!
+ * \brief Receives a reply of known length, e.g. printed with printh/prints.
+ * \param header First byte of the reply, must not be used by other replies
+ * \param data Buffer receiving the bytes after the header
+ * \param length Number of bytes after the header (excluding termination bytes)
+ * \return True if successful
+ *
+ * The payload may contain any bytes, including 0xFF. If the reply times out,
+ * a late reply is waited out while it can still be framed by its length.
+ */
+bool Nextion::receiveRaw(uint8_t header, uint8_t *data, size_t length)
+{
+    m_rawReplyHeader = header;
+    m_rawReplyLength = length + 1;
+
+    bool result = false;
+    bool replied = false;
+    readSolicited([&result, &replied, header, data, length](const std::vector<uint8_t> &buffer,
+                                                            std::size_t messageLength) {
+        replied = true;
+        if (messageLength != length + 1 || buffer[0] != header)
+        {
+            NextionLog("Nextion::receiveRaw: Unexpected response.\n");
+            return;
+        }
+        memcpy(data, &buffer[1], length);
+        result = true;
+    });
+    if (!replied)
+    {
+        discardLateReplies(1);
+    }
+
+    m_rawReplyLength = 0;
+    return result;
+}
+
+/*!
+ * \brief Waits out replies still to come after a reply timed out, so they are
+ *        not taken for the replies of the next request.
+ * \param count Maximum number of replies to discard
+ *
+ * Stops at the first reply that does not arrive within the timeout.
+ */
+void Nextion::discardLateReplies(size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        bool replied = false;
+        readSolicited([&replied](const std::vector<uint8_t> &buffer, std::size_t length) {
+            // Only used for logging
+            (void)buffer;
+            (void)length;
+            NextionLog("Nextion::discardLateReplies: Discarding late reply: ");
+            NextionLogBin(buffer, 0, length);
+            replied = true;
+        });
+        if (!replied)
+        {
+            return;
+        }
+    }
+}
+
+/*!
+ * \brief Checks if the result of each command is sent by the device.
+ * \return True if results are required
+ * \see Nextion::requireCommandResult
+ */
+bool Nextion::isCommandResultRequired() const
+{
+    return m_commandResultRequired;
+}
+
 /*!
  * \brief Receive a string from the device.
  * \param buffer Pointer to buffer to store string in
@@ -746,7 +1817,7 @@ size_t Nextion::receiveString(String &strBuffer)
             return;
         }
         strBuffer.reserve(length - 1);
-        for (uint8_t i = 1; i < length; ++i)
+        for (std::size_t i = 1; i < length; ++i)
         {
             strBuffer.concat((char)buffer[i]);
         }
@@ -759,6 +1830,65 @@ size_t Nextion::receiveString(String &strBuffer)
     return result;
 }
 
+/*!
+ * \brief Receives a string from the device into a caller provided buffer.
+ * \param buffer Buffer to store the string in, always null terminated if size
+ *               is not 0
+ * \param size Size of the buffer in bytes
+ * \return Length of the string received, which may be larger than size - 1 if
+ *         it was truncated (like snprintf), 0 on failure
+ *
+ * The string is copied straight from the receive buffer, surrounding
+ * whitespace is removed as in receiveString(String &).
+ */
+size_t Nextion::receiveString(char *buffer, size_t size)
+{
+    size_t result = 0;
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+
+    readSolicited([&result, buffer, size](const std::vector<uint8_t> &frame, std::size_t length) {
+        if (length == 0)
+        {
+            NextionLog("Nextion::receiveString: Reading response timed out.\n");
+            return;
+        }
+        if (frame[0] != NEX_RET_STRING_HEAD)
+        {
+            NextionLog("Nextion::receiveString: Unexpected response.\n");
+            return;
+        }
+
+        size_t start = 1;
+        size_t end = length;
+        while (start < end && isspace(frame[start]))
+        {
+            ++start;
+        }
+        while (end > start && isspace(frame[end - 1]))
+        {
+            --end;
+        }
+
+        result = end - start;
+        if (size > 0)
+        {
+            size_t copied = std::min(result, size - 1);
+            memcpy(buffer, &frame[start], copied);
+            buffer[copied] = '\0';
+        }
+
+        if (result >= size)
+        {
+            NextionLog("Nextion::receiveString: Truncated %u bytes to %u\n", result, size > 0 ? size - 1 : 0);
+        }
+    });
+
+    return result;
+}
+
 bool Nextion::waitForFirmwareChunkAck() const
 {
     uint64_t start = millis();
@@ -870,4 +2000,358 @@ bool Nextion::uploadFirmware(Stream &stream, size_t size, uint32_t baudrate, Str
         NextionLog("Nextion::uploadFirmware:Stream terminated prematurely, aborting.\n");
         return false;
     }
-}
\ No newline at end of file
+}
+
+/*!
+ * \brief Sets the baud rate of the serial link.
+ * \param baudrate Baud rate the serial port was opened with
+ *
+ * Used to calculate the bandwidth budgets of queued commands, the transmit
+ * time included in reply timeouts and the default drain rate of the flow
+ * control.
+ */
+void Nextion::setBaudRate(uint32_t baudrate)
+{
+    m_scheduler.setBaudRate(baudrate);
+    m_linkMonitor.setBaudRate(baudrate);
+    m_flowControl.setBaudRate(baudrate);
+}
+
+/*!
+ * \brief Queues a command to be sent by a later call to Nextion::poll().
+ * \param priority Priority class of the command
+ * \param command Command to send
+ * \param maxAge Time in ms after which the command is dropped if it has not
+ *               been sent yet, 0 to never drop it
+ * \param key Key of the property the command writes, a pending command with
+ *            the same key is superseded
+ * \return True if the command was queued
+ * \see NextionCommandScheduler::enqueue
+ */
+bool Nextion::queueCommand(NextionPriority priority, const String &command, uint32_t maxAge,
+                           const String &key)
+{
+    return m_scheduler.enqueue(priority, command, maxAge, key);
+}
+
+/*!
+ * \brief Formats and queues a command to be sent by a later call to
+ *        Nextion::poll().
+ * \param priority Priority class of the command
+ * \param maxAge Time in ms after which the command is dropped if it has not
+ *               been sent yet, 0 to never drop it
+ * \param format Format string
+ * \return True if the command was queued
+ */
+bool Nextion::queueCommand(NextionPriority priority, uint32_t maxAge, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = formatCommand(format, args);
+    va_end(args);
+    if (written < 0)
+    {
+        return false;
+    }
+    return m_scheduler.enqueue(priority, String(&m_printBuffer[0]), maxAge);
+}
+
+/*!
+ * \brief Sends queued commands as far as the bandwidth budgets allow.
+ * \return Number of commands sent
+ */
+size_t Nextion::processQueue()
+{
+    return m_scheduler.service([this](const String &command) {
+        sendCommand(command);
+        if (!checkCommandComplete())
+        {
+            NextionLog("Nextion::processQueue: Queued command failed: %s\n", command.c_str());
+        }
+    });
+}
+
+/*!
+ * \brief Gets the scheduler holding queued commands.
+ * \return Scheduler
+ */
+NextionCommandScheduler &Nextion::getScheduler()
+{
+    return m_scheduler;
+}
+
+/*!
+ * \brief Gets the monitor deciding reply timeouts and tracking the health of
+ *        the link.
+ * \return Link monitor
+ */
+NextionLinkMonitor &Nextion::getLinkMonitor()
+{
+    return m_linkMonitor;
+}
+
+/*!
+ * \brief Probes the device, waiting for the probe timeout even if the link is
+ *        known to be dead.
+ * \return True if the device replied
+ *
+ * Called by poll() while the link is dead. The page last known to be displayed
+ * is not updated, so it can be restored if the device restarted.
+ */
+bool Nextion::checkLink()
+{
+    m_linkMonitor.beginProbe();
+    uint32_t page;
+    sendCommand("get dp");
+    bool result = receiveNumber(page);
+    m_linkMonitor.endProbe();
+    NextionLog("Nextion::checkLink: %s\n", result ? "alive" : "no reply");
+    return result;
+}
+
+/*!
+ * \brief Gets the store of widget state replayed after the device restarted.
+ * \return State store
+ */
+NextionStateStore &Nextion::getStateStore()
+{
+    return m_stateStore;
+}
+
+/*!
+ * \brief Sends the retained state of a page in order of priority.
+ * \param pageID Page ID
+ * \return True if all commands were successful
+ */
+bool Nextion::replayState(uint8_t pageID)
+{
+    bool result = true;
+    NextionCommandBatch batch(NEXTION_STATE_REPLAY_BURST + 64);
+    m_stateStore.replay(pageID, [this, &batch, &result](const String &command) {
+        batch.add(command);
+        if (batch.getSize() >= NEXTION_STATE_REPLAY_BURST)
+        {
+            result &= sendBatch(batch);
+            batch.clear();
+        }
+    });
+    result &= sendBatch(batch);
+
+    NextionLog("Nextion::replayState: State of page %u replayed\n", pageID);
+    return result;
+}
+
+/*!
+ * \brief Restores the state of the device after it restarted.
+ * \return True if successful
+ *
+ * Repeats the setup of init() with the current command result setting, shows
+ * the page last known to be displayed and replays its retained state. Called
+ * by poll() when the device reports NEX_RET_EVENT_LAUNCHED or a dead link
+ * replies again. The credit of commands still outstanding is returned, since
+ * the device lost its input buffer, and commands queued in the scheduler are
+ * dropped, as the replayed state supersedes them. Anything drawn directly on
+ * the screen has to be redrawn by the recovery callback.
+ */
+bool Nextion::recover()
+{
+    m_recoveryPending = false;
+    ++m_recoveries;
+    NextionLog("Nextion::recover: Restoring page %u\n", m_currentPage);
+
+    m_buffer.clear();
+    m_reframeBuffer.clear();
+    m_solicitedBuffer.clear();
+    m_discarding = false;
+    m_replyLate = false;
+    // Commands written before the restart were lost with the device buffer
+    // and will never be acknowledged
+    m_flowControl.reset();
+    m_scheduler.clear();
+
+    // The device starts with its default bkcmd and page 0
+    bool result = requireCommandResult(m_commandResultRequired);
+    if (m_currentPage != 0)
+    {
+        sendCommand(String("page ") + String(m_currentPage));
+        result &= checkCommandComplete();
+    }
+    result &= replayState(m_currentPage);
+
+    if (m_recoveryCallback)
+    {
+        m_recoveryCallback(result);
+    }
+    return result;
+}
+
+/*!
+ * \brief Sets the function called after the device state was recovered.
+ * \param callback Callback, e.g. to redraw the screen or invalidate a
+ *                 NextionDirtyTracker
+ */
+void Nextion::setRecoveryCallback(const RecoveryCallback &callback)
+{
+    m_recoveryCallback = callback;
+}
+
+/*!
+ * \brief Gets the number of times the device state was recovered.
+ * \return Number of recoveries
+ */
+uint32_t Nextion::getRecoveryCount() const
+{
+    return m_recoveries;
+}
+
+/*!
+ * \brief Records a write to the device, replies are timed from it.
+ * \param size Number of bytes written
+ * \param slow Whether the write holds a command the device takes long to
+ *             execute, its reply gets the full timeout
+ */
+void Nextion::recordWrite(std::size_t size, bool slow)
+{
+    m_lastWriteTime = micros();
+    m_lastWriteSize = size;
+    m_replyPending = true;
+    m_slowReply = slow;
+}
+
+/*!
+ * \brief Waits for the reply to the last write if it timed out, so it is not
+ *        taken for the reply to the next write.
+ *
+ * The device replies in order, so a late reply arrives before the reply to
+ * the next write. One that does not arrive within the timeout is lost.
+ */
+void Nextion::dropLateReply()
+{
+    if (!m_replyLate)
+    {
+        return;
+    }
+    m_replyLate = false;
+    // Its latency says nothing about the link
+    m_replyPending = false;
+    discardLateReplies(1);
+}
+
+/*!
+ * \brief Checks if the device takes long to execute a command, as it redraws
+ *        the screen or restarts.
+ * \param command Command
+ * \param length Length of the command
+ * \return True for page, ref and rest
+ */
+bool Nextion::isSlowCommand(const uint8_t *command, std::size_t length)
+{
+    static const char *const slowCommands[] = {"page ", "ref ", "rest"};
+    for (const char *slowCommand : slowCommands)
+    {
+        std::size_t slowLength = strlen(slowCommand);
+        if (length >= slowLength && memcmp(command, slowCommand, slowLength) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief Sets whether touch events and value change notifications are queued
+ *        instead of being dispatched while received messages are parsed.
+ * \param deferred If events should be queued
+ * \param dispatchOnPoll If Nextion::poll() should dispatch the queued events,
+ *                       otherwise Nextion::dispatchEvents() has to be called
+ *
+ * Deferred events keep slow callbacks from delaying parsing and allow
+ * callbacks to safely update widgets.
+ *
+ * Dispatching touches the driver state and callbacks usually write to
+ * widgets, so Nextion::dispatchEvents() must be called from the task that
+ * calls Nextion::poll(), e.g. later in the same loop.
+ */
+void Nextion::setDeferredEvents(bool deferred, bool dispatchOnPoll)
+{
+    m_deferEvents = deferred;
+    m_dispatchOnPoll = dispatchOnPoll;
+}
+
+/*!
+ * \brief Calls the callbacks of queued events.
+ * \return Number of events dispatched
+ *
+ * Not thread safe, must be called from the task that calls Nextion::poll().
+ */
+size_t Nextion::dispatchEvents()
+{
+    size_t count = 0;
+    NextionTouchEvent event;
+    while (m_eventQueue.pop(event))
+    {
+        if (event.kind == NEX_EVENT_KIND_TOUCH)
+        {
+            dispatchTouchEvent(event);
+        }
+        else
+        {
+            dispatchValueChange(event);
+        }
+        ++count;
+    }
+    return count;
+}
+
+/*!
+ * \brief Gets the time the touch event being dispatched was received.
+ * \return Value of micros() when the event was received
+ *
+ * Only meaningful while a touch event is dispatched, i.e. from
+ * INextionTouchable::processEvent and touch callbacks. Deferred events keep
+ * the time they were received rather than dispatched.
+ */
+uint32_t Nextion::getEventTimestamp() const
+{
+    return m_eventTimestamp;
+}
+
+/*!
+ * \brief Gets the number of events lost because the event queue was
+ *        full.
+ * \return Number of lost events
+ */
+uint32_t Nextion::getEventOverflowCount() const
+{
+    return m_eventOverflows;
+}
+
+/*!
+ * \brief Passes a touch event to the registered touchables.
+ * \param event Touch event
+ */
+void Nextion::dispatchTouchEvent(const NextionTouchEvent &event)
+{
+    m_eventTimestamp = event.timestamp;
+    for (auto iter = m_touchableList.cbegin(); iter != m_touchableList.cend(); ++iter)
+    {
+        if ((*iter)->processEvent(event.pageID, event.componentID, event.eventType))
+        {
+            NextionLog("Nextion::dispatchTouchEvent: NEX_RET_EVENT_TOUCH_HEAD was handled by: %s\n", (*iter)->getName().c_str());
+        }
+    }
+    NextionLog("Nextion::dispatchTouchEvent: NEX_RET_EVENT_TOUCH_HEAD processing completed\n");
+}
+
+/*!
+ * \brief Passes a value change notification to the registered subscriptions.
+ * \param event Value change event
+ */
+void Nextion::dispatchValueChange(const NextionTouchEvent &event)
+{
+    for (auto iter = m_valueSubscriptionList.cbegin(); iter != m_valueSubscriptionList.cend(); ++iter)
+    {
+        (*iter)->processValueChange(event.pageID, event.componentID, event.value,
+                                    event.kind == NEX_EVENT_KIND_FINAL_VALUE);
+    }
+}
@@ -11,14 +11,68 @@ extern char *itoa(int a, char *buffer, unsigned char radix);
 #include <FS.h>
 
 #include <WString.h>
+#include <deque>
 #include <forward_list>
 #include <list>
 #include <vector>
 #include <functional>
 
+#include "NextionCommandBatch.h"
+#include "NextionCommandScheduler.h"
+#include "NextionFlowControl.h"
+#include "NextionLinkMonitor.h"
+#include "NextionResult.h"
+#include "NextionRingBuffer.h"
+#include "NextionStateStore.h"
 #include "NextionTypes.h"
 
+#ifndef NEXTION_VALUE_CHANGE_HEAD
+#define NEXTION_VALUE_CHANGE_HEAD 0x80 //!< First byte of value change notifications sent by event code
+#endif
+
+#ifndef NEXTION_VALUE_FINAL_HEAD
+#define NEXTION_VALUE_FINAL_HEAD 0x81 //!< First byte of notifications of the final value, e.g. on release
+#endif
+
+#ifndef NEXTION_BULK_READ_HEAD
+#define NEXTION_BULK_READ_HEAD 0x7E //!< First byte of packed bulk read replies, must not be used by the HMI
+#endif
+
+#ifndef NEXTION_STATE_REPLAY_BURST
+#define NEXTION_STATE_REPLAY_BURST 256 //!< Bytes of retained state sent before their results are read
+#endif
+
+#ifndef NEXTION_MAX_MESSAGE_LENGTH
+#define NEXTION_MAX_MESSAGE_LENGTH 1024 //!< Longest message received, longer ones are dropped
+#endif
+
+#ifndef NEXTION_SOLICITED_BUFFER_LIMIT
+#define NEXTION_SOLICITED_BUFFER_LIMIT 4096 //!< Bytes of unread replies kept, the oldest are dropped beyond
+#endif
+
+#ifndef NEXTION_EVENT_QUEUE_LENGTH
+#define NEXTION_EVENT_QUEUE_LENGTH 16 //!< Number of deferred events held, power of two
+#endif
+
+class INextionChannel;
+class INextionPageListener;
+class INextionPollListener;
 class INextionTouchable;
+class NextionValueSubscription;
+
+/*!
+ * \struct NextionTouchEvent
+ * \brief A touch event or value change notification received from the device.
+ */
+struct NextionTouchEvent
+{
+    uint8_t kind;        //!< Kind of the event (see NextionEventKind)
+    uint8_t pageID;      //!< Page ID of the component
+    uint8_t componentID; //!< Component ID of the component
+    uint8_t eventType;   //!< Type of a touch event (see NextionEventType)
+    uint32_t value;      //!< Value of a value change notification
+    uint32_t timestamp;  //!< Value of micros() when the event was received
+};
 
 /*!
  * \class Nextion
@@ -27,15 +81,27 @@ class INextionTouchable;
 class Nextion
 {
 public:
+    /*!
+     * \typedef RecoveryCallback
+     * \brief Called after the state was restored following a restart of the
+     *        device, with whether all commands succeeded.
+     */
+    typedef std::function<void(bool success)> RecoveryCallback;
+
     Nextion(Stream &stream, uint16_t timeout = 1000);
 
     bool init();
     bool requireCommandResult(bool require);
+    bool isCommandResultRequired() const;
     void poll();
     bool reset();
 
     bool refresh();
     bool refresh(const String &objectName);
+    bool requestRefresh(const String &objectName);
+    bool flushRefresh();
+    void setDeferredRefresh(bool deferred, size_t refreshAllThreshold = 8);
+    bool isRefreshDeferred() const;
 
     bool sleep();
     bool wake();
@@ -44,6 +110,8 @@ public:
     bool setBrightness(uint16_t brightness, bool persist = false);
 
     bool getCurrentPage(uint8_t &id);
+    uint8_t getCurrentPageID() const;
+    void notifyPageChanged(uint8_t id);
 
     bool clear(uint32_t colour = NEX_COL_WHITE);
     bool drawPicture(uint16_t x, uint16_t y, uint8_t id);
@@ -94,32 +162,139 @@ public:
 
     void registerTouchable(INextionTouchable *touchable);
     void unregisterTouchable(INextionTouchable *touchable);
+    void registerPageListener(INextionPageListener *listener);
+    void unregisterPageListener(INextionPageListener *listener);
+    void registerPollListener(INextionPollListener *listener);
+    void unregisterPollListener(INextionPollListener *listener);
+    void registerValueSubscription(NextionValueSubscription *subscription);
+    void unregisterValueSubscription(NextionValueSubscription *subscription);
+    bool registerChannel(INextionChannel *channel);
+    void unregisterChannel(INextionChannel *channel);
     void sendCommand(const char *command, std::size_t commandSize);
     void sendCommand(const String &command);
     void sendCommand(const char *format, ...);
     void sendCommand(const char *format, va_list args);
+    void sendCommandWithString(const String &str, const char *format, ...);
+    bool sendBatch(const NextionCommandBatch &batch);
+    void writeBatch(const NextionCommandBatch &batch);
     bool checkCommandComplete(bool overrideRequireCommandResult = false);
+    NextionResult getCommandResult(bool overrideRequireCommandResult = false);
+    NextionResult getLastResult() const;
+    void setRetryPolicy(const NextionRetryPolicy &policy);
+    const NextionRetryPolicy &getRetryPolicy() const;
+    uint32_t getRetryCount() const;
+    uint32_t getThrottle() const;
+    NextionFlowControl &getFlowControl();
+    uint32_t getParseErrorCount() const;
     bool receiveNumber(uint32_t &number);
+    size_t receiveNumbers(uint32_t *values, uint8_t *status, size_t count);
+    bool receiveRaw(uint8_t header, uint8_t *data, size_t length);
     size_t receiveString(String &buffer);
+    size_t receiveString(char *buffer, size_t size);
     bool uploadFirmware(Stream &stream, size_t size, uint32_t baudrate,
                         String &md5Out, size_t bufferSize = 128);
 
+    void setBaudRate(uint32_t baudrate);
+    bool queueCommand(NextionPriority priority, const String &command, uint32_t maxAge = 0,
+                      const String &key = String());
+    bool queueCommand(NextionPriority priority, uint32_t maxAge, const char *format, ...);
+    size_t processQueue();
+    NextionCommandScheduler &getScheduler();
+    NextionLinkMonitor &getLinkMonitor();
+    bool checkLink();
+
+    NextionStateStore &getStateStore();
+    bool replayState(uint8_t pageID);
+    bool recover();
+    void setRecoveryCallback(const RecoveryCallback &callback);
+    uint32_t getRecoveryCount() const;
+
+    void setDeferredEvents(bool deferred, bool dispatchOnPoll = true);
+    size_t dispatchEvents();
+    uint32_t getEventOverflowCount() const;
+    uint32_t getEventTimestamp() const;
+
 private:
     Stream &m_serialPort; //!< Serial port device is attached to
-    uint64_t m_timeout;
     std::forward_list<INextionTouchable *>
         m_touchableList; //!< Linked list of INextionTouchable
+    std::forward_list<INextionPageListener *>
+        m_pageListenerList; //!< Linked list of INextionPageListener
+    std::forward_list<INextionPollListener *>
+        m_pollListenerList; //!< Linked list of INextionPollListener
+    std::forward_list<NextionValueSubscription *>
+        m_valueSubscriptionList; //!< Linked list of NextionValueSubscription
+    std::forward_list<INextionChannel *>
+        m_channelList; //!< Linked list of INextionChannel
+    uint8_t m_currentPage;  //!< ID of the page last known to be displayed
+    bool m_pageRequested;   //!< Whether getCurrentPage() waits for the page ID
     std::vector<uint8_t> m_buffer;
+    std::deque<uint8_t> m_reframeBuffer; //!< Bytes after a broken message, read again before the serial port
     std::vector<uint8_t> m_solicitedBuffer;
     std::vector<uint8_t> m_unsolicitedBuffer;
+    std::vector<std::pair<std::size_t, uint32_t>>
+        m_unsolicitedTimestamps; //!< Offset in m_unsolicitedBuffer and micros() of each message received
     std::vector<char> m_printBuffer;
     bool m_commandResultRequired;
+    NextionCommandScheduler m_scheduler; //!< Queued commands waiting to be sent
+    NextionRingBuffer<NextionTouchEvent, NEXTION_EVENT_QUEUE_LENGTH>
+        m_eventQueue;          //!< Events waiting to be dispatched
+    bool m_deferEvents;        //!< Whether events are queued instead of dispatched
+    bool m_dispatchOnPoll;     //!< Whether poll() dispatches queued events
+    uint32_t m_eventOverflows; //!< Events lost because the queue was full
+    bool m_deferRefresh;                //!< Whether refreshes are collected until flushRefresh()
+    size_t m_refreshAllThreshold;       //!< Number of dirty objects above which the page is refreshed
+    std::vector<String> m_dirtyObjects; //!< Objects waiting to be refreshed
+    uint8_t m_rawReplyHeader;           //!< Header of the raw reply being received
+    size_t m_rawReplyLength;            //!< Length of the raw reply being received, 0 if none
+    std::size_t m_messageLength;        //!< Fixed length of the message being read, 0 if it varies
+    uint32_t m_eventTimestamp;          //!< Time the touch event being dispatched was received
+    NextionLinkMonitor m_linkMonitor;   //!< Reply timeouts and link health
+    uint32_t m_lastWriteTime;           //!< Value of micros() after the last write
+    std::size_t m_lastWriteSize;        //!< Bytes of the last write
+    bool m_replyPending;                //!< Whether no reply was read since the last write
+
+    NextionStateStore m_stateStore;      //!< Widget state replayed after a restart
+    bool m_recoveryPending;              //!< Whether the device restarted and poll() should recover
+    RecoveryCallback m_recoveryCallback; //!< Called after recovering
+    uint32_t m_recoveries;               //!< Number of recoveries
+    NextionRetryPolicy m_retryPolicy;    //!< How transient failures are retried
+    NextionCommandBatch m_lastCommand;   //!< Last command sent, kept to retry it
+    NextionResult m_lastResult;          //!< Last command result read
+    uint32_t m_retries;                  //!< Number of commands sent again
+    uint32_t m_throttle;                 //!< Gap kept between writes in us
+    NextionFlowControl m_flowControl;    //!< Occupancy of the device input buffer
+    bool m_discarding;                   //!< Whether bytes are dropped until the next termination
+    uint32_t m_parseErrors;              //!< Number of broken messages dropped
+    bool m_slowReply;                    //!< Whether the last write holds a command the device takes long to execute
+    bool m_replyLate;                    //!< Whether the reply to the last write timed out and may still arrive
 
-    bool checkCommandCompleteIntrn(const std::vector<uint8_t> &buffer,
-                                   std::size_t length);
+    NextionResult checkCommandCompleteIntrn(const std::vector<uint8_t> &buffer,
+                                            std::size_t length);
+    NextionResult readCommandResult();
+    void readBatchResults(const NextionCommandBatch &batch, bool &result, NextionCommandBatch &retry);
+    bool isRetryable(const NextionResult &result) const;
+    void waitBeforeRetry(uint32_t &backoff);
+    void recordResult(const NextionResult &result);
+    void pace();
+    void waitForCredit(std::size_t size);
+    void discardLateReplies(size_t count);
     void readSolicited(const std::function<void(const std::vector<uint8_t> &buffer,
                                                 std::size_t length)> &callback);
     void readMessage(bool waitForSolicited);
+    void resync();
+    void limitSolicitedBuffer();
+    bool isMessageUnsolicited(uint8_t commandId) const;
+    static bool isSlowCommand(const uint8_t *command, std::size_t length);
+    INextionChannel *findChannel(uint8_t header) const;
+    std::size_t getFixedMessageLength(uint8_t commandId) const;
+    bool calcMessageLength(const std::vector<uint8_t> &buffer, std::size_t start,
+                           std::size_t &length) const;
     void processUnsolicited();
+    int formatCommand(const char *format, va_list args);
+    void dispatchTouchEvent(const NextionTouchEvent &event);
+    void dispatchValueChange(const NextionTouchEvent &event);
+    void recordWrite(std::size_t size, bool slow);
+    void dropLateReply();
     bool waitForFirmwareChunkAck() const;
 };
@@ -0,0 +1,178 @@
+/*! \file */
+
+#include "NextionBulkRead.h"
+#include "NextionCommandBatch.h"
+#include "NextionLogger.h"
+
+/*!
+ * \brief Creates an empty bulk read.
+ * \param nex Driver to read with
+ */
+NextionBulkRead::NextionBulkRead(Nextion &nex)
+    : m_nextion(nex)
+{
+}
+
+/*!
+ * \brief Adds a variable to read.
+ * \param variable Name of the variable, e.g. "n0.val" or "sys0"
+ * \return Index of the value
+ */
+size_t NextionBulkRead::add(const String &variable)
+{
+    m_variables.push_back(variable);
+    m_values.push_back(0);
+    m_valid.push_back(false);
+    return m_variables.size() - 1;
+}
+
+/*!
+ * \brief Adds a numerical property of a widget to read.
+ * \param widget Widget
+ * \param propertyName Name of the property
+ * \return Index of the value
+ */
+size_t NextionBulkRead::add(INextionWidget &widget, const String &propertyName)
+{
+    return add(widget.getName() + "." + propertyName);
+}
+
+/*!
+ * \brief Removes all variables.
+ */
+void NextionBulkRead::clear()
+{
+    m_variables.clear();
+    m_values.clear();
+    m_valid.clear();
+}
+
+/*!
+ * \brief Reads all variables using pipelined get commands.
+ * \return Number of values read successfully
+ *
+ * Requests are sent in windows of NEXTION_BULK_READ_WINDOW bytes so the serial
+ * buffer of the device does not overflow; the replies of a window are read
+ * before the next one is sent. If a reply times out, the late replies of its
+ * window are waited out, so they are not taken for values of the next one.
+ */
+size_t NextionBulkRead::read()
+{
+    size_t received = 0;
+    NextionCommandBatch batch(NEXTION_BULK_READ_WINDOW + 32);
+    size_t first = 0;
+    for (size_t i = 0; i < m_variables.size(); i++)
+    {
+        batch.addf("get %s", m_variables[i].c_str());
+        if (batch.getSize() >= NEXTION_BULK_READ_WINDOW || i + 1 == m_variables.size())
+        {
+            m_nextion.writeBatch(batch);
+            received += m_nextion.receiveNumbers(&m_values[first], &m_valid[first], i + 1 - first);
+            batch.clear();
+            first = i + 1;
+        }
+    }
+
+    NextionLog("NextionBulkRead::read: %u of %u values read\n", received, m_variables.size());
+    return received;
+}
+
+/*!
+ * \brief Reads all variables in a single reply frame.
+ * \return Number of values read successfully, which is either all or none
+ *
+ * The device prints the values with printh/prints into one frame starting with
+ * NEXTION_BULK_READ_HEAD followed by 4 bytes (little endian) per value, which
+ * saves the framing of a reply per value. Each printh/prints would be
+ * acknowledged separately when command results are required, so read() is
+ * used instead in that case. Any failing variable fails the whole read.
+ */
+size_t NextionBulkRead::readPacked()
+{
+    if (m_nextion.isCommandResultRequired())
+    {
+        NextionLog("NextionBulkRead::readPacked: Command results required, using pipelined read\n");
+        return read();
+    }
+
+    setAllValid(false);
+    if (m_variables.empty())
+    {
+        return 0;
+    }
+
+    NextionCommandBatch batch(m_variables.size() * 20 + 32);
+    batch.addf("printh %02X", NEXTION_BULK_READ_HEAD);
+    for (size_t i = 0; i < m_variables.size(); i++)
+    {
+        batch.addf("prints %s,4", m_variables[i].c_str());
+    }
+    batch.addf("printh FF FF FF");
+    m_nextion.writeBatch(batch);
+
+    std::vector<uint8_t> data(m_variables.size() * 4);
+    if (!m_nextion.receiveRaw(NEXTION_BULK_READ_HEAD, &data[0], data.size()))
+    {
+        NextionLog("NextionBulkRead::readPacked: Reply not received\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < m_variables.size(); i++)
+    {
+        const uint8_t *value = &data[i * 4];
+        m_values[i] = ((uint32_t)value[3] << 24) | ((uint32_t)value[2] << 16) | ((uint32_t)value[1] << 8) | (value[0]);
+    }
+
+    setAllValid(true);
+    return m_variables.size();
+}
+
+/*!
+ * \brief Gets the number of variables.
+ * \return Number of variables
+ */
+size_t NextionBulkRead::size() const
+{
+    return m_variables.size();
+}
+
+/*!
+ * \brief Checks if a value was read successfully by the last read.
+ * \param index Index of the value
+ * \return True if valid
+ */
+bool NextionBulkRead::isValid(size_t index) const
+{
+    return index < m_variables.size() && m_valid[index];
+}
+
+/*!
+ * \brief Gets a value read by the last read.
+ * \param index Index of the value
+ * \return Value, only meaningful if isValid() is true
+ */
+uint32_t NextionBulkRead::getValue(size_t index) const
+{
+    return index < m_values.size() ? m_values[index] : 0;
+}
+
+/*!
+ * \brief Gets all values read by the last read, in the order they were added.
+ * \return Pointer to size() values
+ */
+const uint32_t *NextionBulkRead::getValues() const
+{
+    return m_values.data();
+}
+
+/*!
+ * \brief Sets the status of all values.
+ * \param valid Status
+ */
+void NextionBulkRead::setAllValid(bool valid)
+{
+    for (size_t i = 0; i < m_variables.size(); i++)
+    {
+        m_valid[i] = valid;
+    }
+}
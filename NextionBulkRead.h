@@ -0,0 +1,46 @@
+/*! \file */
+
+#pragma once
+
+#include <vector>
+
+#include "INextionWidget.h"
+#include "Nextion.h"
+
+#ifndef NEXTION_BULK_READ_WINDOW
+#define NEXTION_BULK_READ_WINDOW 256 //!< Bytes of requests sent before their replies are read
+#endif
+
+/*!
+ * \class NextionBulkRead
+ * \brief Reads many numerical values in a single exchange.
+ *
+ * Variables are added once, then read() sends all get commands back-to-back
+ * and collects the replies in order, instead of waiting for each reply before
+ * sending the next request.
+ */
+class NextionBulkRead
+{
+public:
+    NextionBulkRead(Nextion &nex);
+
+    size_t add(const String &variable);
+    size_t add(INextionWidget &widget, const String &propertyName = "val");
+    void clear();
+
+    size_t read();
+    size_t readPacked();
+
+    size_t size() const;
+    bool isValid(size_t index) const;
+    uint32_t getValue(size_t index) const;
+    const uint32_t *getValues() const;
+
+private:
+    void setAllValid(bool valid);
+
+    Nextion &m_nextion;              //!< Driver to read with
+    std::vector<String> m_variables; //!< Variables to read, e.g. "n0.val"
+    std::vector<uint32_t> m_values;  //!< Values read
+    std::vector<uint8_t> m_valid;    //!< If each value was read successfully
+};
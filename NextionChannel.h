@@ -0,0 +1,106 @@
+/*! \file */
+
+#pragma once
+
+#include <functional>
+#include <string.h>
+#include <type_traits>
+
+#include "INextionChannel.h"
+
+/*!
+ * \class NextionChannel
+ * \brief Channel decoding its payload into a struct.
+ *
+ * The payload is copied as is into a T, so T should be a packed struct
+ * (__attribute__((packed))) whose fields match the bytes sent by the HMI,
+ * which are little endian for prints of numerical values:
+ *
+ * \code
+ * struct __attribute__((packed)) Keypad
+ * {
+ *     uint8_t key;
+ *     int32_t value;
+ * };
+ * // Event code: printh 90, prints key,1, prints n0.val,4, printh FF FF FF
+ * NextionChannel<Keypad> keypad(0x90, [](const Keypad &k) { ... });
+ * nex.registerChannel(&keypad);
+ * \endcode
+ *
+ * \tparam T Type of the payload
+ */
+template <typename T>
+class NextionChannel : public INextionChannel
+{
+    static_assert(std::is_trivially_copyable<T>::value, "NextionChannel payload must be trivially copyable");
+
+public:
+    /*!
+     * \typedef Handler
+     * \brief Function called with each decoded message.
+     */
+    typedef std::function<void(const T &)> Handler;
+
+    /*!
+     * \brief Creates a new channel.
+     * \param header Header byte of the messages
+     * \param handler Function called with each decoded message
+     */
+    NextionChannel(uint8_t header, const Handler &handler = Handler())
+        : INextionChannel(header, sizeof(T))
+        , m_handler(handler)
+        , m_last()
+        , m_count(0)
+    {
+    }
+
+    /*!
+     * \brief Sets the function called with each decoded message.
+     * \param handler Handler
+     */
+    void setHandler(const Handler &handler)
+    {
+        m_handler = handler;
+    }
+
+    /*!
+     * \brief Gets the last message received.
+     * \return Last message, value initialised if none was received
+     */
+    const T &getLast() const
+    {
+        return m_last;
+    }
+
+    /*!
+     * \brief Gets the number of messages received.
+     * \return Number of messages
+     */
+    uint32_t getCount() const
+    {
+        return m_count;
+    }
+
+    /*!
+     * \copydoc INextionChannel::processMessage
+     */
+    void processMessage(const uint8_t *payload, size_t length)
+    {
+        if (length != sizeof(T))
+        {
+            return;
+        }
+
+        memcpy(&m_last, payload, sizeof(T));
+        ++m_count;
+        if (m_handler)
+        {
+            m_handler(m_last);
+        }
+    }
+
+private:
+    Handler m_handler; //!< Called with each decoded message
+    T m_last;          //!< Last message received
+    uint32_t m_count;  //!< Number of messages received
+};
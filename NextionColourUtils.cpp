@@ -0,0 +1,96 @@
+/*! \file */
+
+#include "NextionColourUtils.h"
+
+/*!
+ * \brief Spreads the channels of an RGB565 colour so that each has room to
+ *        hold the product with a 5 bit weight (layout 00000GGG GGG00000
+ *        RRRRR000 000BBBBB).
+ * \param colour RGB565 colour
+ * \return Spread colour
+ */
+static inline uint32_t spread(uint16_t colour)
+{
+    return (colour | (static_cast<uint32_t>(colour) << 16)) & 0x07E0F81F;
+}
+
+/*!
+ * \brief Reverses spread().
+ * \param spreadColour Spread colour
+ * \return RGB565 colour
+ */
+static inline uint16_t unspread(uint32_t spreadColour)
+{
+    spreadColour &= 0x07E0F81F;
+    return static_cast<uint16_t>(spreadColour | (spreadColour >> 16));
+}
+
+/*!
+ * \brief Fills an array with a gradient between two colours.
+ * \param from First colour
+ * \param to Last colour
+ * \param colours Array receiving the gradient
+ * \param count Number of colours to generate
+ *
+ * Blends all three channels with a single multiplication per colour, using
+ * 32 steps between the end colours.
+ */
+void NextionColourUtils::ramp(uint16_t from, uint16_t to, uint16_t *colours, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (count == 1)
+    {
+        colours[0] = from;
+        return;
+    }
+
+    uint32_t spreadFrom = spread(from);
+    uint32_t spreadTo = spread(to);
+
+    // Weight in 16.16 fixed point, advanced by a constant step
+    uint32_t step = (32UL << 16) / (count - 1);
+    uint32_t weight = 0;
+    for (size_t i = 0; i < count - 1; ++i, weight += step)
+    {
+        uint32_t w = weight >> 16;
+        colours[i] = unspread((spreadFrom * (32 - w) + spreadTo * w) >> 5);
+    }
+    colours[count - 1] = to;
+}
+
+/*!
+ * \brief Fills an array with a gradient through several evenly spaced colour
+ *        stops (e.g. green, yellow, red for a gauge).
+ * \param stops Colour stops
+ * \param stopCount Number of colour stops
+ * \param colours Array receiving the gradient
+ * \param count Number of colours to generate
+ */
+void NextionColourUtils::ramp(const uint16_t *stops, size_t stopCount, uint16_t *colours, size_t count)
+{
+    if (stopCount == 0 || count == 0)
+    {
+        return;
+    }
+    if (stopCount == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            colours[i] = stops[0];
+        }
+        return;
+    }
+
+    size_t segments = stopCount - 1;
+    size_t start = 0;
+    for (size_t s = 0; s < segments; ++s)
+    {
+        // Segment s covers [start, end], sharing its end with the next one
+        size_t end = (count - 1) * (s + 1) / segments;
+        ramp(stops[s], stops[s + 1], colours + start, end - start + 1);
+        start = end;
+    }
+}
@@ -0,0 +1,128 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+/*!
+ * \class NextionColourUtils
+ * \brief Conversions to the RGB565 colours used by the device.
+ *
+ * All single colour conversions are constexpr, so conversions of constants
+ * are folded at compile time:
+ * \code
+ * static const uint16_t ALARM_ORANGE = NextionColourUtils::rgb(255, 140, 0);
+ * \endcode
+ */
+class NextionColourUtils
+{
+public:
+    /*!
+     * \brief Converts 8 bit per channel RGB to RGB565.
+     * \param r Red (0-255)
+     * \param g Green (0-255)
+     * \param b Blue (0-255)
+     * \return RGB565 colour
+     */
+    static constexpr uint16_t rgb(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    }
+
+    /*!
+     * \brief Converts a packed RGB888 value (0xRRGGBB) to RGB565.
+     * \param rgb888 Colour
+     * \return RGB565 colour
+     */
+    static constexpr uint16_t fromRgb888(uint32_t rgb888)
+    {
+        return rgb((rgb888 >> 16) & 0xFF, (rgb888 >> 8) & 0xFF, rgb888 & 0xFF);
+    }
+
+    /*!
+     * \brief Converts an RGB565 colour to a packed RGB888 value (0xRRGGBB).
+     * \param colour RGB565 colour
+     * \return RGB888 colour, low bits filled by replicating the high bits
+     */
+    static constexpr uint32_t toRgb888(uint16_t colour)
+    {
+        return (static_cast<uint32_t>(expand5(colour >> 11)) << 16) |
+               (static_cast<uint32_t>(expand6((colour >> 5) & 0x3F)) << 8) |
+               expand5(colour & 0x1F);
+    }
+
+    /*!
+     * \brief Converts HSV to RGB565.
+     * \param h Hue in degrees (0-359, larger values wrap)
+     * \param s Saturation (0-255)
+     * \param v Value (0-255)
+     * \return RGB565 colour
+     */
+    static constexpr uint16_t hsv(uint16_t h, uint8_t s, uint8_t v)
+    {
+        return s == 0 ? rgb(v, v, v)
+                      : hsvSector((h % 360) / 60, v,
+                                  v * (255 - s) / 255,
+                                  v * (255 - s * hueFraction(h) / 255) / 255,
+                                  v * (255 - s * (255 - hueFraction(h)) / 255) / 255);
+    }
+
+    /*!
+     * \brief Interpolates between two RGB565 colours.
+     * \param from Colour at position 0
+     * \param to Colour at position 255
+     * \param position Position between the colours (0-255)
+     * \return RGB565 colour
+     */
+    static constexpr uint16_t lerp(uint16_t from, uint16_t to, uint8_t position)
+    {
+        return static_cast<uint16_t>(
+            (lerpChannel(from >> 11, to >> 11, position) << 11) |
+            (lerpChannel((from >> 5) & 0x3F, (to >> 5) & 0x3F, position) << 5) |
+            lerpChannel(from & 0x1F, to & 0x1F, position));
+    }
+
+    static void ramp(uint16_t from, uint16_t to, uint16_t *colours, size_t count);
+    static void ramp(const uint16_t *stops, size_t stopCount, uint16_t *colours, size_t count);
+
+private:
+    static constexpr uint8_t expand5(uint16_t value)
+    {
+        return static_cast<uint8_t>((value << 3) | (value >> 2));
+    }
+
+    static constexpr uint8_t expand6(uint16_t value)
+    {
+        return static_cast<uint8_t>((value << 2) | (value >> 4));
+    }
+
+    static constexpr uint16_t hueFraction(uint16_t h)
+    {
+        return (h % 60) * 255 / 60;
+    }
+
+    static constexpr uint16_t hsvSector(uint16_t sector, uint8_t v, uint8_t p, uint8_t q, uint8_t t)
+    {
+        return sector == 0 ? rgb(v, t, p)
+             : sector == 1 ? rgb(q, v, p)
+             : sector == 2 ? rgb(p, v, t)
+             : sector == 3 ? rgb(p, q, v)
+             : sector == 4 ? rgb(t, p, v)
+                           : rgb(v, p, q);
+    }
+
+    static constexpr uint16_t lerpChannel(int32_t from, int32_t to, uint8_t position)
+    {
+        return static_cast<uint16_t>((from * (255 - position) + to * position + 127) / 255);
+    }
+};
+
+// Both ends of a gradient are reached, whichever way the channels run
+static_assert(NextionColourUtils::lerp(0xFFFF, 0x0000, 0) == 0xFFFF, "lerp must start at the first colour");
+static_assert(NextionColourUtils::lerp(0xFFFF, 0x0000, 255) == 0x0000, "lerp must end at the second colour");
+static_assert(NextionColourUtils::lerp(0x0000, 0xFFFF, 0) == 0x0000, "lerp must start at the first colour");
+static_assert(NextionColourUtils::lerp(0x0000, 0xFFFF, 255) == 0xFFFF, "lerp must end at the second colour");
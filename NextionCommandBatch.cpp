@@ -0,0 +1,218 @@
+/*! \file */
+
+#include "NextionCommandBatch.h"
+#include "NextionEscape.h"
+#include "NextionLogger.h"
+
+/*!
+ * \brief Creates an empty batch.
+ * \param capacity Number of bytes to reserve
+ */
+NextionCommandBatch::NextionCommandBatch(size_t capacity)
+    : m_count(0)
+{
+    m_buffer.reserve(capacity);
+}
+
+/*!
+ * \brief Appends a command.
+ * \param command Command to append
+ * \param length Length of the command (excluding null character)
+ */
+void NextionCommandBatch::add(const char *command, size_t length)
+{
+    m_buffer.insert(m_buffer.end(), command, command + length);
+    terminate();
+}
+
+/*!
+ * \brief Appends a command.
+ * \param command Command to append
+ */
+void NextionCommandBatch::add(const String &command)
+{
+    add(command.c_str(), command.length());
+}
+
+/*!
+ * \brief Formats and appends a command.
+ * \param format Format string
+ * \return True if successful
+ */
+bool NextionCommandBatch::addf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool result = append(format, args);
+    va_end(args);
+    if (result)
+    {
+        terminate();
+    }
+    return result;
+}
+
+/*!
+ * \brief Formats and appends a command ending in a quoted string, e.g.
+ *        addWithString(text, "t0.txt=").
+ * \param str Text of the string, escaped while it is copied into the batch
+ * \param format Format string of the part before the string
+ * \return True if successful
+ */
+bool NextionCommandBatch::addWithString(const String &str, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool result = append(format, args);
+    va_end(args);
+    if (result)
+    {
+        m_buffer.reserve(m_buffer.size() + NextionEscape::escapedLength(str.c_str(), str.length()) + 5);
+        m_buffer.push_back('\"');
+        NextionEscape::write(*this, str.c_str(), str.length());
+        m_buffer.push_back('\"');
+        terminate();
+    }
+    return result;
+}
+
+/*!
+ * \brief Removes all commands, keeping the reserved memory.
+ */
+void NextionCommandBatch::clear()
+{
+    m_buffer.clear();
+    m_count = 0;
+}
+
+/*!
+ * \brief Gets the number of commands in the batch.
+ * \return Number of commands
+ */
+size_t NextionCommandBatch::getCommandCount() const
+{
+    return m_count;
+}
+
+/*!
+ * \brief Gets a command of the batch.
+ * \param index Index of the command
+ * \param data Set to the start of the command
+ * \param length Set to the length of the command (excluding termination bytes)
+ * \return True if the command exists
+ *
+ * Commands are found by their termination bytes, so this is linear in the
+ * size of the batch. Use getNextCommand() to walk all commands.
+ */
+bool NextionCommandBatch::getCommand(size_t index, const uint8_t *&data, size_t &length) const
+{
+    size_t offset = 0;
+    for (size_t found = 0; getNextCommand(offset, data, length); ++found)
+    {
+        if (found == index)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief Gets the command starting at an offset and advances the offset to the
+ *        next command.
+ * \param offset Offset of the command in the batch, 0 for the first one
+ * \param data Set to the start of the command
+ * \param length Set to the length of the command (excluding termination bytes)
+ * \return True if a command was found, false at the end of the batch
+ */
+bool NextionCommandBatch::getNextCommand(size_t &offset, const uint8_t *&data, size_t &length) const
+{
+    for (size_t i = offset; i + 2 < m_buffer.size(); ++i)
+    {
+        if (m_buffer[i] == 0xFF && m_buffer[i + 1] == 0xFF && m_buffer[i + 2] == 0xFF)
+        {
+            data = &m_buffer[offset];
+            length = i - offset;
+            offset = i + 3;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief Gets the number of bytes the batch occupies on the wire.
+ * \return Size in bytes
+ */
+size_t NextionCommandBatch::getSize() const
+{
+    return m_buffer.size();
+}
+
+/*!
+ * \brief Gets the terminated commands.
+ * \return Pointer to the first byte, only valid if the batch is not empty
+ */
+const uint8_t *NextionCommandBatch::getData() const
+{
+    return m_buffer.data();
+}
+
+/*!
+ * \brief Appends raw bytes to the command being built.
+ * \param data Bytes to append
+ * \param length Number of bytes
+ * \return Number of bytes appended
+ */
+size_t NextionCommandBatch::write(const uint8_t *data, size_t length)
+{
+    m_buffer.insert(m_buffer.end(), data, data + length);
+    return length;
+}
+
+/*!
+ * \brief Formats text onto the end of the buffer without terminating it.
+ * \param format Format string
+ * \param args Format arguments
+ * \return True if successful
+ */
+bool NextionCommandBatch::append(const char *format, va_list args)
+{
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    char buffer[64];
+    int written = vsnprintf(buffer, sizeof(buffer), format, args);
+
+    if (written < 0)
+    {
+        NextionLog("NextionCommandBatch::append: Failed to format the string\n");
+        va_end(argsCopy);
+        return false;
+    }
+
+    if (written < static_cast<int>(sizeof(buffer)))
+    {
+        m_buffer.insert(m_buffer.end(), buffer, buffer + written);
+    }
+    else
+    {
+        // Format straight into the batch buffer
+        size_t start = m_buffer.size();
+        m_buffer.resize(start + written + 1);
+        vsnprintf(reinterpret_cast<char *>(&m_buffer[start]), written + 1, format, argsCopy);
+        m_buffer.resize(start + written);
+    }
+    va_end(argsCopy);
+    return true;
+}
+
+/*!
+ * \brief Terminates the command being built.
+ */
+void NextionCommandBatch::terminate()
+{
+    m_buffer.push_back(0xFF);
+    m_buffer.push_back(0xFF);
+    m_buffer.push_back(0xFF);
+    ++m_count;
+}
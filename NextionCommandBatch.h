@@ -0,0 +1,47 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <WString.h>
+#include <vector>
+
+/*!
+ * \class NextionCommandBatch
+ * \brief A sequence of commands sent to the device in a single write.
+ *
+ * Commands are stored back-to-back with their termination bytes, ready to be
+ * sent by Nextion::sendBatch().
+ */
+class NextionCommandBatch
+{
+public:
+    NextionCommandBatch(size_t capacity = 128);
+
+    void add(const char *command, size_t length);
+    void add(const String &command);
+    bool addf(const char *format, ...);
+    bool addWithString(const String &str, const char *format, ...);
+    void clear();
+
+    size_t getCommandCount() const;
+    bool getCommand(size_t index, const uint8_t *&data, size_t &length) const;
+    bool getNextCommand(size_t &offset, const uint8_t *&data, size_t &length) const;
+    size_t getSize() const;
+    const uint8_t *getData() const;
+
+private:
+    friend class NextionEscape;
+
+    size_t write(const uint8_t *data, size_t length);
+    bool append(const char *format, va_list args);
+    void terminate();
+
+    std::vector<uint8_t> m_buffer; //!< Terminated commands
+    size_t m_count;                //!< Number of commands in the buffer
+};
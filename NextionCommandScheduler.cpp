@@ -0,0 +1,333 @@
+/*! \file */
+
+#include "NextionCommandScheduler.h"
+#include "NextionLogger.h"
+
+/*!
+ * \brief Time window (in ms) of link bandwidth a class may save up.
+ */
+static const uint32_t BURST_WINDOW_MS = 50;
+
+/*!
+ * \brief Minimum number of bytes a class may save up, so that long commands
+ *        are not starved by a small share.
+ */
+static const int32_t MIN_CREDIT_LIMIT = 64;
+
+/*!
+ * \brief Checks if a millis() timestamp is in the past.
+ * \param now Current time
+ * \param deadline Timestamp to check
+ * \return True if the deadline has passed
+ */
+static bool isExpired(uint32_t now, uint32_t deadline)
+{
+    return static_cast<int32_t>(now - deadline) > 0;
+}
+
+/*!
+ * \brief Creates a new scheduler with the default budgets.
+ *
+ * Default shares are 40% interactive, 40% telemetry and 20% bulk, for an
+ * assumed link of 9600 baud.
+ */
+NextionCommandScheduler::NextionCommandScheduler()
+    : m_baudrate(9600)
+    , m_lastService(0)
+    , m_maxQueueLength(32)
+    , m_dropped(0)
+    , m_coalesced(0)
+{
+    m_budgets[NEX_PRIO_ALARM] = 100;
+    m_budgets[NEX_PRIO_INTERACTIVE] = 40;
+    m_budgets[NEX_PRIO_TELEMETRY] = 40;
+    m_budgets[NEX_PRIO_BULK] = 20;
+
+    for (uint8_t i = 0; i < NEX_PRIO_COUNT; ++i)
+    {
+        m_credits[i] = 0;
+        m_remainders[i] = 0;
+    }
+}
+
+/*!
+ * \brief Sets the baud rate the bandwidth budgets are calculated from.
+ * \param baudrate Baud rate of the serial link
+ */
+void NextionCommandScheduler::setBaudRate(uint32_t baudrate)
+{
+    m_baudrate = baudrate;
+}
+
+/*!
+ * \brief Gets the baud rate the bandwidth budgets are calculated from.
+ * \return Baud rate
+ */
+uint32_t NextionCommandScheduler::getBaudRate() const
+{
+    return m_baudrate;
+}
+
+/*!
+ * \brief Sets the share of the link bandwidth a priority class receives when
+ *        several classes have pending commands.
+ * \param priority Priority class
+ * \param percent Share in percent
+ *
+ * Has no effect on NEX_PRIO_ALARM, which is never limited.
+ */
+void NextionCommandScheduler::setBudget(NextionPriority priority, uint8_t percent)
+{
+    if (priority >= NEX_PRIO_COUNT || priority == NEX_PRIO_ALARM)
+    {
+        return;
+    }
+    m_budgets[priority] = percent;
+}
+
+/*!
+ * \brief Sets the maximum number of commands held per priority class.
+ * \param length Maximum queue length
+ */
+void NextionCommandScheduler::setMaxQueueLength(size_t length)
+{
+    m_maxQueueLength = length;
+}
+
+/*!
+ * \brief Adds a command to the queue of a priority class.
+ * \param priority Priority class
+ * \param command Command to send (without termination bytes)
+ * \param maxAge Time in ms after which the command is dropped if it has not
+ *               been sent yet, 0 to never drop it
+ * \param key Key identifying the property the command writes, empty if the
+ *            command should never be coalesced
+ * \return True if the command was queued, false if the queue is full
+ *
+ * If a command with the same key is pending in the same class it is replaced
+ * in place, keeping its position relative to other commands. If it is pending
+ * in another class it is removed and the new command is appended. If the
+ * queue of the class is full the pending command is kept.
+ */
+bool NextionCommandScheduler::enqueue(NextionPriority priority, const String &command, uint32_t maxAge,
+                                      const String &key)
+{
+    if (priority >= NEX_PRIO_COUNT)
+    {
+        return false;
+    }
+
+    Entry entry;
+    entry.command = command;
+    entry.key = key;
+    entry.deadline = millis() + maxAge;
+    entry.hasDeadline = maxAge > 0;
+
+    // Pending command with the same key in another class, removed once the
+    // new command is known to fit
+    std::deque<Entry> *supersededQueue = nullptr;
+    std::deque<Entry>::iterator superseded;
+
+    if (key.length() > 0)
+    {
+        for (uint8_t i = 0; i < NEX_PRIO_COUNT && supersededQueue == nullptr; ++i)
+        {
+            std::deque<Entry> &queue = m_queues[i];
+            for (auto iter = queue.begin(); iter != queue.end(); ++iter)
+            {
+                if (iter->key != key)
+                {
+                    continue;
+                }
+
+                if (i == priority)
+                {
+                    ++m_coalesced;
+                    *iter = entry;
+                    return true;
+                }
+                supersededQueue = &queue;
+                superseded = iter;
+                break;
+            }
+        }
+    }
+
+    std::deque<Entry> &queue = m_queues[priority];
+    if (queue.size() >= m_maxQueueLength)
+    {
+        NextionLog("NextionCommandScheduler::enqueue: Queue %u is full.\n", priority);
+        return false;
+    }
+
+    if (supersededQueue != nullptr)
+    {
+        ++m_coalesced;
+        supersededQueue->erase(superseded);
+    }
+    queue.push_back(entry);
+    return true;
+}
+
+/*!
+ * \brief Sends as many queued commands as the bandwidth budgets allow.
+ * \param send Function used to transmit each command
+ * \return Number of commands sent
+ *
+ * Classes are served in priority order. Stale commands are dropped without
+ * being sent.
+ */
+size_t NextionCommandScheduler::service(const SendFunction &send)
+{
+    uint32_t now = millis();
+    refill(now);
+
+    size_t sent = 0;
+    for (uint8_t i = 0; i < NEX_PRIO_COUNT; ++i)
+    {
+        std::deque<Entry> &queue = m_queues[i];
+        while (!queue.empty())
+        {
+            Entry &entry = queue.front();
+            if (entry.hasDeadline && isExpired(now, entry.deadline))
+            {
+                NextionLog("NextionCommandScheduler::service: Dropping stale command: %s\n", entry.command.c_str());
+                ++m_dropped;
+                queue.pop_front();
+                continue;
+            }
+
+            if (i != NEX_PRIO_ALARM && m_credits[i] <= 0)
+            {
+                break;
+            }
+
+            // Commands may overdraw the credits, the debt is paid back by
+            // the following refills
+            m_credits[i] -= entry.command.length() + 3;
+            send(entry.command);
+            queue.pop_front();
+            ++sent;
+        }
+
+        if (queue.empty() && m_credits[i] > 0)
+        {
+            m_credits[i] = 0;
+        }
+    }
+    return sent;
+}
+
+/*!
+ * \brief Removes all queued commands.
+ */
+void NextionCommandScheduler::clear()
+{
+    for (uint8_t i = 0; i < NEX_PRIO_COUNT; ++i)
+    {
+        m_queues[i].clear();
+        m_credits[i] = 0;
+        m_remainders[i] = 0;
+    }
+}
+
+/*!
+ * \brief Gets the number of queued commands in all classes.
+ * \return Number of commands
+ */
+size_t NextionCommandScheduler::getPendingCount() const
+{
+    size_t count = 0;
+    for (uint8_t i = 0; i < NEX_PRIO_COUNT; ++i)
+    {
+        count += m_queues[i].size();
+    }
+    return count;
+}
+
+/*!
+ * \brief Gets the number of queued commands in a class.
+ * \param priority Priority class
+ * \return Number of commands
+ */
+size_t NextionCommandScheduler::getPendingCount(NextionPriority priority) const
+{
+    if (priority >= NEX_PRIO_COUNT)
+    {
+        return 0;
+    }
+    return m_queues[priority].size();
+}
+
+/*!
+ * \brief Gets the number of commands dropped because their deadline passed.
+ * \return Number of dropped commands
+ */
+uint32_t NextionCommandScheduler::getDroppedCount() const
+{
+    return m_dropped;
+}
+
+/*!
+ * \brief Gets the number of commands replaced by a newer command with the same
+ *        key before they were sent.
+ * \return Number of coalesced commands
+ */
+uint32_t NextionCommandScheduler::getCoalescedCount() const
+{
+    return m_coalesced;
+}
+
+/*!
+ * \brief Distributes the bandwidth of the time elapsed since the last service
+ *        among the classes that have pending commands.
+ * \param now Current time
+ *
+ * Shares of idle classes are given to the busy ones, so a single busy class
+ * can use the entire link. Fractions of a byte are carried over to the next
+ * refill, so frequent polling does not starve the classes.
+ */
+void NextionCommandScheduler::refill(uint32_t now)
+{
+    uint32_t elapsed = std::min(now - m_lastService, BURST_WINDOW_MS);
+    m_lastService = now;
+
+    uint32_t activeBudget = 0;
+    for (uint8_t i = NEX_PRIO_INTERACTIVE; i < NEX_PRIO_COUNT; ++i)
+    {
+        if (!m_queues[i].empty())
+        {
+            activeBudget += m_budgets[i];
+        }
+    }
+    if (activeBudget == 0)
+    {
+        return;
+    }
+
+    // 10 bits per byte on the wire (start, 8 data, stop), so baud * ms is the
+    // number of bytes in units of 1/10000
+    uint64_t linkUnits = static_cast<uint64_t>(m_baudrate) * elapsed;
+    for (uint8_t i = NEX_PRIO_INTERACTIVE; i < NEX_PRIO_COUNT; ++i)
+    {
+        if (m_queues[i].empty())
+        {
+            continue;
+        }
+        uint64_t units = linkUnits * m_budgets[i] / activeBudget + m_remainders[i];
+        m_remainders[i] = static_cast<uint32_t>(units % 10000);
+        int32_t credit = static_cast<int32_t>(units / 10000);
+        m_credits[i] = std::min(m_credits[i] + credit, creditLimit(static_cast<NextionPriority>(i)));
+    }
+}
+
+/*!
+ * \brief Gets the maximum number of bytes a class may save up.
+ * \param priority Priority class
+ * \return Credit limit in bytes
+ */
+int32_t NextionCommandScheduler::creditLimit(NextionPriority priority) const
+{
+    int32_t limit = static_cast<int32_t>(static_cast<uint64_t>(m_baudrate) * BURST_WINDOW_MS / 10000 * m_budgets[priority] / 100);
+    return std::max(limit, MIN_CREDIT_LIMIT);
+}
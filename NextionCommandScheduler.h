@@ -0,0 +1,82 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <WString.h>
+#include <deque>
+#include <functional>
+
+#include "NextionTypes.h"
+
+/*!
+ * \class NextionCommandScheduler
+ * \brief Holds outgoing commands per priority class and decides which of them
+ *        may be sent next.
+ *
+ * Each class except NEX_PRIO_ALARM gets a share of the link bandwidth, derived
+ * from the baud rate. Alarm commands are always sent first and are not
+ * limited. Commands may carry a deadline after which they are dropped instead
+ * of being sent.
+ *
+ * Commands queued with a key (e.g. "n0.val") supersede a pending command with
+ * the same key, so only the latest write to a property is sent.
+ */
+class NextionCommandScheduler
+{
+public:
+    /*!
+     * \typedef SendFunction
+     * \brief Function used to transmit a scheduled command.
+     */
+    typedef std::function<void(const String &command)> SendFunction;
+
+    NextionCommandScheduler();
+
+    void setBaudRate(uint32_t baudrate);
+    uint32_t getBaudRate() const;
+
+    void setBudget(NextionPriority priority, uint8_t percent);
+    void setMaxQueueLength(size_t length);
+
+    bool enqueue(NextionPriority priority, const String &command, uint32_t maxAge = 0,
+                 const String &key = String());
+    size_t service(const SendFunction &send);
+    void clear();
+
+    size_t getPendingCount() const;
+    size_t getPendingCount(NextionPriority priority) const;
+    uint32_t getDroppedCount() const;
+    uint32_t getCoalescedCount() const;
+
+private:
+    /*!
+     * \struct Entry
+     * \brief A command waiting in a priority class queue.
+     */
+    struct Entry
+    {
+        String command;     //!< Command text, without termination bytes
+        String key;         //!< Key of the written property, empty if none
+        uint32_t deadline;  //!< millis() value after which the command is stale
+        bool hasDeadline;   //!< Whether deadline is valid
+    };
+
+    std::deque<Entry> m_queues[NEX_PRIO_COUNT]; //!< One FIFO per priority class
+    int32_t m_credits[NEX_PRIO_COUNT];          //!< Bytes each class may still send
+    uint32_t m_remainders[NEX_PRIO_COUNT];      //!< Fractions of a byte not yet credited, in 1/10000 bytes
+    uint8_t m_budgets[NEX_PRIO_COUNT];          //!< Bandwidth share in percent
+    uint32_t m_baudrate;
+    uint32_t m_lastService;
+    size_t m_maxQueueLength;
+    uint32_t m_dropped;
+    uint32_t m_coalesced;
+
+    void refill(uint32_t now);
+    int32_t creditLimit(NextionPriority priority) const;
+};
@@ -0,0 +1,259 @@
+/*! \file */
+
+#include "NextionDirtyTracker.h"
+#include "NextionLogger.h"
+#include <algorithm>
+
+/*!
+ * \brief Creates a new tracker, the first frame repaints the whole screen.
+ * \param screenWidth Width of the screen in pixels
+ * \param screenHeight Height of the screen in pixels
+ * \param background Colour of the screen behind all primitives
+ */
+NextionDirtyTracker::NextionDirtyTracker(uint16_t screenWidth, uint16_t screenHeight, uint32_t background)
+    : m_previous(screenWidth, screenHeight)
+    , m_current(screenWidth, screenHeight)
+    , m_output(screenWidth, screenHeight)
+    , m_background(background)
+    , m_valid(false)
+{
+}
+
+/*!
+ * \brief Gets the display list to record the next frame into.
+ * \return Display list of the next frame
+ *
+ * The frame must not clear the screen itself, the background colour is used
+ * for that.
+ */
+NextionDisplayList &NextionDirtyTracker::frame()
+{
+    return m_current;
+}
+
+/*!
+ * \brief Draws the changes between the recorded frame and the previous one.
+ * \param nex Driver of the device
+ * \param maxBurst Maximum number of bytes sent at once, see
+ *                 NextionDisplayList::submit
+ * \return True if all commands were successful
+ *
+ * On failure the next frame repaints the whole screen.
+ */
+bool NextionDirtyTracker::endFrame(Nextion &nex, size_t maxBurst)
+{
+    m_current.optimise();
+    m_output.reset();
+    m_damage.clear();
+
+    const NextionRect screen = m_current.getScreen();
+    const std::vector<NextionPrimitive> &current = m_current.getPrimitives();
+
+    if (m_valid)
+    {
+        // Compare in drawing order, any difference damages both versions
+        const std::vector<NextionPrimitive> &previous = m_previous.getPrimitives();
+        size_t count = std::max(previous.size(), current.size());
+        for (size_t i = 0; i < count; i++)
+        {
+            bool hasPrevious = i < previous.size();
+            bool hasCurrent = i < current.size();
+            if (hasPrevious && hasCurrent && previous[i] == current[i])
+            {
+                continue;
+            }
+            if (hasPrevious)
+            {
+                addDamage(NextionDisplayList::bounds(previous[i], screen));
+            }
+            if (hasCurrent)
+            {
+                addDamage(NextionDisplayList::bounds(current[i], screen));
+            }
+        }
+        mergeDamage();
+    }
+    else
+    {
+        m_damage.push_back(screen);
+    }
+
+    uint32_t area = getDamagedArea();
+    if (area == 0)
+    {
+        std::swap(m_previous, m_current);
+        m_current.reset();
+        return true;
+    }
+
+    if (area * 4 >= static_cast<uint32_t>(screen.x2) * screen.y2 * 3)
+    {
+        // Most of the screen changed, a single clear is cheaper
+        m_damage.assign(1, screen);
+        m_output.clear(m_background);
+    }
+    else
+    {
+        for (auto iter = m_damage.cbegin(); iter != m_damage.cend(); ++iter)
+        {
+            m_output.drawRect(iter->x1, iter->y1, iter->x2 - iter->x1, iter->y2 - iter->y1, true, m_background);
+        }
+    }
+
+    // Redrawing a primitive repaints its whole bounds, so anything drawn
+    // after it on top of those bounds has to be redrawn as well
+    std::vector<NextionRect> repainted(m_damage);
+    for (auto iter = current.cbegin(); iter != current.cend(); ++iter)
+    {
+        NextionRect rect = NextionDisplayList::bounds(*iter, screen);
+        if (intersectsAny(repainted, rect))
+        {
+            m_output.add(*iter);
+            repainted.push_back(rect);
+        }
+    }
+
+    NextionLog("NextionDirtyTracker::endFrame: %u of %u primitives, %u pixels damaged\n",
+               m_output.size(), current.size(), area);
+
+    bool result = m_output.submit(nex, maxBurst);
+    m_valid = result;
+    std::swap(m_previous, m_current);
+    m_current.reset();
+    return result;
+}
+
+/*!
+ * \brief Forces the next frame to repaint the whole screen.
+ */
+void NextionDirtyTracker::invalidate()
+{
+    m_valid = false;
+}
+
+/*!
+ * \brief Sets the background colour, which repaints the whole screen with the
+ *        next frame.
+ * \param colour Background colour
+ */
+void NextionDirtyTracker::setBackground(uint32_t colour)
+{
+    if (colour != m_background)
+    {
+        m_background = colour;
+        m_valid = false;
+    }
+}
+
+/*!
+ * \brief Gets the background colour.
+ * \return Background colour
+ */
+uint32_t NextionDirtyTracker::getBackground() const
+{
+    return m_background;
+}
+
+/*!
+ * \brief Gets the areas that changed in the last frame.
+ * \return Damaged rectangles
+ */
+const std::vector<NextionRect> &NextionDirtyTracker::getDamage() const
+{
+    return m_damage;
+}
+
+/*!
+ * \brief Gets the number of pixels in the damaged rectangles.
+ * \return Damaged area, overlapping rectangles are counted more than once
+ */
+uint32_t NextionDirtyTracker::getDamagedArea() const
+{
+    uint32_t area = 0;
+    for (auto iter = m_damage.cbegin(); iter != m_damage.cend(); ++iter)
+    {
+        if (!iter->isEmpty())
+        {
+            area += static_cast<uint32_t>(iter->x2 - iter->x1) * (iter->y2 - iter->y1);
+        }
+    }
+    return area;
+}
+
+/*!
+ * \brief Adds a damaged rectangle, clipped to the screen.
+ * \param rect Damaged rectangle
+ */
+void NextionDirtyTracker::addDamage(const NextionRect &rect)
+{
+    const NextionRect screen = m_current.getScreen();
+    NextionRect clipped;
+    clipped.x1 = std::max(rect.x1, screen.x1);
+    clipped.y1 = std::max(rect.y1, screen.y1);
+    clipped.x2 = std::min(rect.x2, screen.x2);
+    clipped.y2 = std::min(rect.y2, screen.y2);
+    if (!clipped.isEmpty())
+    {
+        m_damage.push_back(clipped);
+    }
+}
+
+/*!
+ * \brief Replaces overlapping damaged rectangles with their union, and all of
+ *        them with a single one if there are too many.
+ */
+void NextionDirtyTracker::mergeDamage()
+{
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < m_damage.size() && !merged; i++)
+        {
+            for (size_t j = i + 1; j < m_damage.size(); j++)
+            {
+                if (m_damage[i].intersects(m_damage[j]))
+                {
+                    m_damage[i].x1 = std::min(m_damage[i].x1, m_damage[j].x1);
+                    m_damage[i].y1 = std::min(m_damage[i].y1, m_damage[j].y1);
+                    m_damage[i].x2 = std::max(m_damage[i].x2, m_damage[j].x2);
+                    m_damage[i].y2 = std::max(m_damage[i].y2, m_damage[j].y2);
+                    m_damage.erase(m_damage.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (m_damage.size() > NEXTION_DIRTY_TRACKER_MAX_RECTS)
+    {
+        NextionRect all = m_damage.front();
+        for (auto iter = m_damage.cbegin() + 1; iter != m_damage.cend(); ++iter)
+        {
+            all.x1 = std::min(all.x1, iter->x1);
+            all.y1 = std::min(all.y1, iter->y1);
+            all.x2 = std::max(all.x2, iter->x2);
+            all.y2 = std::max(all.y2, iter->y2);
+        }
+        m_damage.assign(1, all);
+    }
+}
+
+/*!
+ * \brief Checks if a rectangle intersects any rectangle of a list.
+ * \param rects Rectangles to check against
+ * \param rect Rectangle to check
+ * \return True if it intersects
+ */
+bool NextionDirtyTracker::intersectsAny(const std::vector<NextionRect> &rects, const NextionRect &rect)
+{
+    for (auto iter = rects.cbegin(); iter != rects.cend(); ++iter)
+    {
+        if (iter->intersects(rect))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+/*! \file */
+
+#pragma once
+
+#include <vector>
+
+#include "Nextion.h"
+#include "NextionDisplayList.h"
+
+#ifndef NEXTION_DIRTY_TRACKER_MAX_RECTS
+#define NEXTION_DIRTY_TRACKER_MAX_RECTS 8 //!< Damaged rectangles kept before merging all of them
+#endif
+
+/*!
+ * \class NextionDirtyTracker
+ * \brief Redraws only the parts of the screen that changed between frames.
+ *
+ * Each frame is recorded into frame() and compared with the previous one.
+ * Damaged areas are filled with the background colour and only primitives
+ * intersecting them are drawn again, instead of clearing and repainting the
+ * whole screen.
+ *
+ * The tracker assumes it is the only thing drawing to the screen; call
+ * invalidate() after anything else did (e.g. after a page change).
+ */
+class NextionDirtyTracker
+{
+public:
+    NextionDirtyTracker(uint16_t screenWidth, uint16_t screenHeight, uint32_t background = NEX_COL_WHITE);
+
+    NextionDisplayList &frame();
+    bool endFrame(Nextion &nex, size_t maxBurst = 512);
+
+    void invalidate();
+    void setBackground(uint32_t colour);
+    uint32_t getBackground() const;
+
+    const std::vector<NextionRect> &getDamage() const;
+    uint32_t getDamagedArea() const;
+
+private:
+    void addDamage(const NextionRect &rect);
+    void mergeDamage();
+    static bool intersectsAny(const std::vector<NextionRect> &rects, const NextionRect &rect);
+
+    NextionDisplayList m_previous;     //!< Frame currently on screen
+    NextionDisplayList m_current;      //!< Frame being recorded
+    NextionDisplayList m_output;       //!< Commands of the last update
+    std::vector<NextionRect> m_damage; //!< Damaged areas of the last update
+    uint32_t m_background;             //!< Colour damaged areas are filled with
+    bool m_valid;                      //!< If m_previous matches the screen
+};
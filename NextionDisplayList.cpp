@@ -0,0 +1,523 @@
+/*! \file */
+
+#include "NextionDisplayList.h"
+#include "NextionLogger.h"
+#include <algorithm>
+
+/*!
+ * \brief Compares two primitives.
+ * \param other Primitive to compare with
+ * \return True if both draw exactly the same
+ */
+bool NextionPrimitive::operator==(const NextionPrimitive &other) const
+{
+    return type == other.type && x == other.x && y == other.y && w == other.w && h == other.h &&
+           x2 == other.x2 && y2 == other.y2 && r == other.r && colour == other.colour &&
+           bgColour == other.bgColour && id == other.id && bgType == other.bgType &&
+           xCentre == other.xCentre && yCentre == other.yCentre && text == other.text;
+}
+
+/*!
+ * \brief Compares two primitives.
+ * \param other Primitive to compare with
+ * \return True if they draw differently
+ */
+bool NextionPrimitive::operator!=(const NextionPrimitive &other) const
+{
+    return !(*this == other);
+}
+
+/*!
+ * \brief Checks if the rectangle covers no pixels.
+ * \return True if empty
+ */
+bool NextionRect::isEmpty() const
+{
+    return x1 >= x2 || y1 >= y2;
+}
+
+/*!
+ * \brief Checks if another rectangle lies entirely within this one.
+ * \param other Rectangle to check
+ * \return True if contained
+ */
+bool NextionRect::contains(const NextionRect &other) const
+{
+    return other.x1 >= x1 && other.y1 >= y1 && other.x2 <= x2 && other.y2 <= y2;
+}
+
+/*!
+ * \brief Checks if another rectangle shares pixels with this one.
+ * \param other Rectangle to check
+ * \return True if they intersect
+ */
+bool NextionRect::intersects(const NextionRect &other) const
+{
+    return other.x1 < x2 && other.x2 > x1 && other.y1 < y2 && other.y2 > y1;
+}
+
+/*!
+ * \brief Creates an empty display list.
+ * \param screenWidth Width of the screen in pixels
+ * \param screenHeight Height of the screen in pixels
+ */
+NextionDisplayList::NextionDisplayList(uint16_t screenWidth, uint16_t screenHeight)
+    : m_screenWidth(screenWidth)
+    , m_screenHeight(screenHeight)
+{
+}
+
+/*!
+ * \brief Removes all recorded primitives.
+ */
+void NextionDisplayList::reset()
+{
+    m_primitives.clear();
+}
+
+/*!
+ * \copydoc Nextion::clear
+ */
+void NextionDisplayList::clear(uint32_t colour)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = NEX_PRIM_CLEAR;
+    primitive.w = m_screenWidth;
+    primitive.h = m_screenHeight;
+    primitive.colour = colour;
+    add(primitive);
+}
+
+/*!
+ * \brief Records drawing a pre uploaded picture.
+ * \param x X position
+ * \param y Y position
+ * \param id ID of the picture to display
+ */
+void NextionDisplayList::drawPicture(uint16_t x, uint16_t y, uint8_t id)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = NEX_PRIM_PICTURE;
+    primitive.x = x;
+    primitive.y = y;
+    primitive.id = id;
+    add(primitive);
+}
+
+/*!
+ * \brief Records drawing a cropped pre uploaded picture.
+ * \param x X position
+ * \param y Y position
+ * \param w Width
+ * \param h Height
+ * \param id ID of the picture to display
+ */
+void NextionDisplayList::drawPicture(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t id)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = NEX_PRIM_CROP_PICTURE;
+    primitive.x = x;
+    primitive.y = y;
+    primitive.w = w;
+    primitive.h = h;
+    primitive.id = id;
+    add(primitive);
+}
+
+/*!
+ * \brief Records drawing a string.
+ * \see Nextion::drawStr
+ */
+void NextionDisplayList::drawStr(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t fontID,
+                                 const String &str, uint32_t bgColour, uint32_t fgColour, uint8_t bgType,
+                                 NextionFontAlignment xCentre, NextionFontAlignment yCentre)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = NEX_PRIM_STRING;
+    primitive.x = x;
+    primitive.y = y;
+    primitive.w = w;
+    primitive.h = h;
+    primitive.id = fontID;
+    primitive.text = str;
+    primitive.bgColour = bgColour;
+    primitive.colour = fgColour;
+    primitive.bgType = bgType;
+    primitive.xCentre = xCentre;
+    primitive.yCentre = yCentre;
+    add(primitive);
+}
+
+/*!
+ * \brief Records drawing a line.
+ * \see Nextion::drawLine
+ */
+void NextionDisplayList::drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint32_t colour)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = NEX_PRIM_LINE;
+    primitive.x = x1;
+    primitive.y = y1;
+    primitive.x2 = x2;
+    primitive.y2 = y2;
+    primitive.colour = colour;
+    add(primitive);
+}
+
+/*!
+ * \brief Records drawing a rectangle.
+ * \see Nextion::drawRect
+ */
+void NextionDisplayList::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool filled, uint32_t colour)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = filled ? NEX_PRIM_FILLED_RECT : NEX_PRIM_RECT;
+    primitive.x = x;
+    primitive.y = y;
+    primitive.w = w;
+    primitive.h = h;
+    primitive.colour = colour;
+    add(primitive);
+}
+
+/*!
+ * \brief Records drawing a circle.
+ * \see Nextion::drawCircle
+ */
+void NextionDisplayList::drawCircle(uint16_t x, uint16_t y, uint16_t r, bool filled, uint32_t colour)
+{
+    NextionPrimitive primitive = NextionPrimitive();
+    primitive.type = filled ? NEX_PRIM_FILLED_CIRCLE : NEX_PRIM_CIRCLE;
+    primitive.x = x;
+    primitive.y = y;
+    primitive.r = r;
+    primitive.colour = colour;
+    add(primitive);
+}
+
+/*!
+ * \brief Records a primitive.
+ * \param primitive Primitive
+ */
+void NextionDisplayList::add(const NextionPrimitive &primitive)
+{
+    m_primitives.push_back(primitive);
+}
+
+/*!
+ * \brief Removes primitives that would not be visible and merges lines.
+ * \return Number of primitives removed
+ */
+size_t NextionDisplayList::optimise()
+{
+    size_t removed = cull();
+    removed += mergeLines();
+    NextionLog("NextionDisplayList::optimise: Removed %u primitives, %u left\n", removed, m_primitives.size());
+    return removed;
+}
+
+/*!
+ * \brief Optimises the list and sends it to the device.
+ * \param nex Driver of the device
+ * \param maxBurst Maximum number of bytes sent before waiting for the results
+ *                 of the commands sent so far, to avoid overflowing the serial
+ *                 buffer of the device
+ * \return True if all commands were successful
+ *
+ * The recorded primitives are kept, see NextionDisplayList::reset.
+ */
+bool NextionDisplayList::submit(Nextion &nex, size_t maxBurst)
+{
+    optimise();
+
+    bool result = true;
+    NextionCommandBatch batch(maxBurst + 64);
+    for (auto iter = m_primitives.cbegin(); iter != m_primitives.cend(); ++iter)
+    {
+        appendCommand(batch, *iter);
+        if (batch.getSize() >= maxBurst)
+        {
+            result &= nex.sendBatch(batch);
+            batch.clear();
+        }
+    }
+    result &= nex.sendBatch(batch);
+    return result;
+}
+
+/*!
+ * \brief Gets the number of recorded primitives.
+ * \return Number of primitives
+ */
+size_t NextionDisplayList::size() const
+{
+    return m_primitives.size();
+}
+
+/*!
+ * \brief Gets the recorded primitives.
+ * \return Primitives in drawing order
+ */
+const std::vector<NextionPrimitive> &NextionDisplayList::getPrimitives() const
+{
+    return m_primitives;
+}
+
+/*!
+ * \brief Gets the rectangle covering the screen.
+ * \return Screen rectangle
+ */
+NextionRect NextionDisplayList::getScreen() const
+{
+    NextionRect screen = {0, 0, m_screenWidth, m_screenHeight};
+    return screen;
+}
+
+/*!
+ * \brief Gets the rectangle a primitive may draw to.
+ * \param primitive Primitive
+ * \param screen Screen rectangle, used for primitives of unknown size
+ * \return Bounding rectangle
+ */
+NextionRect NextionDisplayList::bounds(const NextionPrimitive &primitive, const NextionRect &screen)
+{
+    NextionRect rect;
+    switch (primitive.type)
+    {
+    case NEX_PRIM_CLEAR:
+        return screen;
+
+    case NEX_PRIM_LINE:
+        rect.x1 = std::min(primitive.x, primitive.x2);
+        rect.y1 = std::min(primitive.y, primitive.y2);
+        rect.x2 = std::max(primitive.x, primitive.x2) + 1;
+        rect.y2 = std::max(primitive.y, primitive.y2) + 1;
+        return rect;
+
+    case NEX_PRIM_RECT:
+        // Outlines include the far edge
+        rect.x1 = primitive.x;
+        rect.y1 = primitive.y;
+        rect.x2 = primitive.x + primitive.w + 1;
+        rect.y2 = primitive.y + primitive.h + 1;
+        return rect;
+
+    case NEX_PRIM_CIRCLE:
+    case NEX_PRIM_FILLED_CIRCLE:
+        rect.x1 = static_cast<int32_t>(primitive.x) - primitive.r;
+        rect.y1 = static_cast<int32_t>(primitive.y) - primitive.r;
+        rect.x2 = primitive.x + primitive.r + 1;
+        rect.y2 = primitive.y + primitive.r + 1;
+        return rect;
+
+    case NEX_PRIM_PICTURE:
+        // Size of the picture is unknown
+        rect.x1 = primitive.x;
+        rect.y1 = primitive.y;
+        rect.x2 = std::max<int32_t>(screen.x2, primitive.x + 1);
+        rect.y2 = std::max<int32_t>(screen.y2, primitive.y + 1);
+        return rect;
+
+    default:
+        rect.x1 = primitive.x;
+        rect.y1 = primitive.y;
+        rect.x2 = primitive.x + primitive.w;
+        rect.y2 = primitive.y + primitive.h;
+        return rect;
+    }
+}
+
+/*!
+ * \brief Checks if a primitive covers its entire bounding rectangle.
+ * \param primitive Primitive
+ * \return True if opaque
+ */
+bool NextionDisplayList::isOpaque(const NextionPrimitive &primitive)
+{
+    switch (primitive.type)
+    {
+    case NEX_PRIM_CLEAR:
+    case NEX_PRIM_FILLED_RECT:
+    case NEX_PRIM_CROP_PICTURE:
+        return true;
+    case NEX_PRIM_STRING:
+        return primitive.bgType == NEX_BG_SOLIDCOLOUR;
+    default:
+        return false;
+    }
+}
+
+/*!
+ * \brief Appends the command drawing a primitive to a batch.
+ * \param batch Batch to append to
+ * \param primitive Primitive
+ */
+void NextionDisplayList::appendCommand(NextionCommandBatch &batch, const NextionPrimitive &primitive)
+{
+    switch (primitive.type)
+    {
+    case NEX_PRIM_CLEAR:
+        batch.addf("cls %u", primitive.colour);
+        break;
+    case NEX_PRIM_LINE:
+        batch.addf("line %u,%u,%u,%u,%u", primitive.x, primitive.y, primitive.x2, primitive.y2, primitive.colour);
+        break;
+    case NEX_PRIM_RECT:
+        batch.addf("draw %u,%u,%u,%u,%u", primitive.x, primitive.y, primitive.x + primitive.w, primitive.y + primitive.h, primitive.colour);
+        break;
+    case NEX_PRIM_FILLED_RECT:
+        batch.addf("fill %u,%u,%u,%u,%u", primitive.x, primitive.y, primitive.w, primitive.h, primitive.colour);
+        break;
+    case NEX_PRIM_CIRCLE:
+        batch.addf("cir %u,%u,%u,%u", primitive.x, primitive.y, primitive.r, primitive.colour);
+        break;
+    case NEX_PRIM_FILLED_CIRCLE:
+        batch.addf("cirs %u,%u,%u,%u", primitive.x, primitive.y, primitive.r, primitive.colour);
+        break;
+    case NEX_PRIM_PICTURE:
+        batch.addf("pic %u,%u,%u", primitive.x, primitive.y, primitive.id);
+        break;
+    case NEX_PRIM_CROP_PICTURE:
+        batch.addf("picq %u,%u,%u,%u,%u", primitive.x, primitive.y, primitive.w, primitive.h, primitive.id);
+        break;
+    case NEX_PRIM_STRING:
+        batch.addWithString(primitive.text, "xstr %u,%u,%u,%u,%u,%u,%u,%d,%d,%u,", primitive.x, primitive.y,
+                            primitive.w, primitive.h, primitive.id, primitive.colour, primitive.bgColour,
+                            primitive.xCentre, primitive.yCentre, primitive.bgType);
+        break;
+    }
+}
+
+/*!
+ * \brief Removes primitives outside the screen or covered by a later opaque
+ *        primitive.
+ * \return Number of primitives removed
+ */
+size_t NextionDisplayList::cull()
+{
+    NextionRect screen = getScreen();
+    std::vector<NextionRect> rects;
+    rects.reserve(m_primitives.size());
+    for (auto iter = m_primitives.cbegin(); iter != m_primitives.cend(); ++iter)
+    {
+        rects.push_back(bounds(*iter, screen));
+    }
+
+    std::vector<bool> keep(m_primitives.size(), true);
+    NextionRect cover = {0, 0, 0, 0};
+    for (size_t i = m_primitives.size(); i-- > 0;)
+    {
+        if (!rects[i].intersects(screen))
+        {
+            keep[i] = false;
+            continue;
+        }
+
+        // Clip to the screen, anything outside is not visible anyway
+        NextionRect visible = rects[i];
+        visible.x1 = std::max(visible.x1, screen.x1);
+        visible.y1 = std::max(visible.y1, screen.y1);
+        visible.x2 = std::min(visible.x2, screen.x2);
+        visible.y2 = std::min(visible.y2, screen.y2);
+
+        if (cover.contains(visible))
+        {
+            keep[i] = false;
+            continue;
+        }
+        for (size_t j = i + 1; j < m_primitives.size(); ++j)
+        {
+            if (keep[j] && isOpaque(m_primitives[j]) && rects[j].contains(visible))
+            {
+                keep[i] = false;
+                break;
+            }
+        }
+
+        if (keep[i] && m_primitives[i].type == NEX_PRIM_CLEAR)
+        {
+            // Everything drawn before a clear is covered
+            cover = screen;
+        }
+    }
+
+    size_t removed = 0;
+    size_t out = 0;
+    for (size_t i = 0; i < m_primitives.size(); ++i)
+    {
+        if (keep[i])
+        {
+            if (out != i)
+            {
+                m_primitives[out] = m_primitives[i];
+            }
+            ++out;
+        }
+        else
+        {
+            ++removed;
+        }
+    }
+    m_primitives.resize(out);
+    return removed;
+}
+
+/*!
+ * \brief Merges consecutive horizontal or vertical lines of the same colour
+ *        that overlap or touch.
+ * \return Number of primitives removed
+ */
+size_t NextionDisplayList::mergeLines()
+{
+    if (m_primitives.size() < 2)
+    {
+        return 0;
+    }
+
+    size_t out = 0;
+    for (size_t i = 1; i < m_primitives.size(); ++i)
+    {
+        NextionPrimitive &last = m_primitives[out];
+        const NextionPrimitive &next = m_primitives[i];
+        bool merged = false;
+
+        if (last.type == NEX_PRIM_LINE && next.type == NEX_PRIM_LINE && last.colour == next.colour)
+        {
+            if (last.y == last.y2 && next.y == next.y2 && last.y == next.y)
+            {
+                uint16_t lo1 = std::min(last.x, last.x2), hi1 = std::max(last.x, last.x2);
+                uint16_t lo2 = std::min(next.x, next.x2), hi2 = std::max(next.x, next.x2);
+                if (lo2 <= hi1 + 1 && lo1 <= hi2 + 1)
+                {
+                    last.x = std::min(lo1, lo2);
+                    last.x2 = std::max(hi1, hi2);
+                    merged = true;
+                }
+            }
+            else if (last.x == last.x2 && next.x == next.x2 && last.x == next.x)
+            {
+                uint16_t lo1 = std::min(last.y, last.y2), hi1 = std::max(last.y, last.y2);
+                uint16_t lo2 = std::min(next.y, next.y2), hi2 = std::max(next.y, next.y2);
+                if (lo2 <= hi1 + 1 && lo1 <= hi2 + 1)
+                {
+                    last.y = std::min(lo1, lo2);
+                    last.y2 = std::max(hi1, hi2);
+                    merged = true;
+                }
+            }
+        }
+
+        if (!merged)
+        {
+            ++out;
+            if (out != i)
+            {
+                m_primitives[out] = next;
+            }
+        }
+    }
+
+    size_t removed = m_primitives.size() - (out + 1);
+    m_primitives.resize(out + 1);
+    return removed;
+}
@@ -0,0 +1,118 @@
+/*! \file */
+
+#pragma once
+
+#include <vector>
+
+#include "Nextion.h"
+#include "NextionCommandBatch.h"
+#include "NextionTypes.h"
+
+/*!
+ * \enum NextionPrimitiveType
+ * \brief Types of primitives recorded by NextionDisplayList.
+ */
+enum NextionPrimitiveType
+{
+    NEX_PRIM_CLEAR,         //!< cls
+    NEX_PRIM_LINE,          //!< line
+    NEX_PRIM_RECT,          //!< draw (outline)
+    NEX_PRIM_FILLED_RECT,   //!< fill
+    NEX_PRIM_CIRCLE,        //!< cir
+    NEX_PRIM_FILLED_CIRCLE, //!< cirs
+    NEX_PRIM_PICTURE,       //!< pic
+    NEX_PRIM_CROP_PICTURE,  //!< picq
+    NEX_PRIM_STRING         //!< xstr
+};
+
+/*!
+ * \struct NextionPrimitive
+ * \brief A recorded drawing operation.
+ *
+ * Lines use (x, y) and (x2, y2) as their end points; circles use (x, y) as
+ * centre and r as radius; all other primitives use (x, y, w, h).
+ */
+struct NextionPrimitive
+{
+    NextionPrimitiveType type;
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t x2;
+    uint16_t y2;
+    uint16_t r;
+    uint32_t colour;   //!< Colour, foreground colour for strings
+    uint32_t bgColour; //!< Background colour of strings
+    uint8_t id;        //!< Picture or font ID
+    uint8_t bgType;    //!< Background type of strings
+    NextionFontAlignment xCentre;
+    NextionFontAlignment yCentre;
+    String text; //!< Text of strings
+
+    bool operator==(const NextionPrimitive &other) const;
+    bool operator!=(const NextionPrimitive &other) const;
+};
+
+/*!
+ * \struct NextionRect
+ * \brief A rectangle covering [x1, x2) x [y1, y2).
+ */
+struct NextionRect
+{
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
+
+    bool isEmpty() const;
+    bool contains(const NextionRect &other) const;
+    bool intersects(const NextionRect &other) const;
+};
+
+/*!
+ * \class NextionDisplayList
+ * \brief Records drawing primitives and submits them to the device as a few
+ *        large writes instead of one exchange per primitive.
+ *
+ * Before submission primitives outside the screen or covered entirely by a
+ * later opaque primitive are removed, and touching horizontal or vertical
+ * lines of the same colour are merged.
+ */
+class NextionDisplayList
+{
+public:
+    NextionDisplayList(uint16_t screenWidth, uint16_t screenHeight);
+
+    void reset();
+
+    void clear(uint32_t colour = NEX_COL_WHITE);
+    void drawPicture(uint16_t x, uint16_t y, uint8_t id);
+    void drawPicture(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t id);
+    void drawStr(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t fontID, const String &str,
+                 uint32_t bgColour, uint32_t fgColour, uint8_t bgType,
+                 NextionFontAlignment xCentre, NextionFontAlignment yCentre);
+    void drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint32_t colour);
+    void drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool filled, uint32_t colour);
+    void drawCircle(uint16_t x, uint16_t y, uint16_t r, bool filled, uint32_t colour);
+    void add(const NextionPrimitive &primitive);
+
+    size_t optimise();
+    bool submit(Nextion &nex, size_t maxBurst = 512);
+
+    size_t size() const;
+    const std::vector<NextionPrimitive> &getPrimitives() const;
+    NextionRect getScreen() const;
+
+    static NextionRect bounds(const NextionPrimitive &primitive, const NextionRect &screen);
+    static bool isOpaque(const NextionPrimitive &primitive);
+    static void appendCommand(NextionCommandBatch &batch, const NextionPrimitive &primitive);
+
+private:
+    size_t cull();
+    size_t mergeLines();
+
+    std::vector<NextionPrimitive> m_primitives; //!< Recorded primitives in drawing order
+    uint16_t m_screenWidth;
+    uint16_t m_screenHeight;
+};
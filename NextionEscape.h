@@ -0,0 +1,104 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <WString.h>
+
+/*!
+ * \class NextionEscape
+ * \brief Escapes text for use inside a quoted string of a command.
+ *
+ * Characters are copied in spans between the ones that need escaping (" and \),
+ * so no copy of the whole text is made.
+ */
+class NextionEscape
+{
+public:
+    /*!
+     * \brief Checks if a character has to be escaped.
+     * \param c Character
+     * \return True if it needs a preceding backslash
+     */
+    static bool needsEscape(char c)
+    {
+        return c == '\"' || c == '\\';
+    }
+
+    /*!
+     * \brief Gets the length of text after escaping.
+     * \param str Text
+     * \param length Length of the text
+     * \return Escaped length
+     */
+    static size_t escapedLength(const char *str, size_t length)
+    {
+        size_t escaped = length;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (needsEscape(str[i]))
+            {
+                escaped++;
+            }
+        }
+        return escaped;
+    }
+
+    /*!
+     * \brief Writes escaped text to a sink.
+     * \tparam Sink Anything with write(const uint8_t *, size_t), e.g. a Stream
+     * \param sink Sink to write to
+     * \param str Text
+     * \param length Length of the text
+     * \return Number of bytes written
+     */
+    template <typename Sink>
+    static size_t write(Sink &sink, const char *str, size_t length)
+    {
+        static const uint8_t backslash = '\\';
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(str);
+        size_t written = 0;
+        size_t spanStart = 0;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (needsEscape(str[i]))
+            {
+                if (i > spanStart)
+                {
+                    written += sink.write(data + spanStart, i - spanStart);
+                }
+                written += sink.write(&backslash, 1);
+                spanStart = i;
+            }
+        }
+        if (length > spanStart)
+        {
+            written += sink.write(data + spanStart, length - spanStart);
+        }
+        return written;
+    }
+
+    /*!
+     * \brief Appends escaped text to a String.
+     * \param out String to append to
+     * \param str Text
+     * \param length Length of the text
+     */
+    static void append(String &out, const char *str, size_t length)
+    {
+        out.reserve(out.length() + escapedLength(str, length));
+        for (size_t i = 0; i < length; i++)
+        {
+            if (needsEscape(str[i]))
+            {
+                out += '\\';
+            }
+            out += str[i];
+        }
+    }
+};
@@ -0,0 +1,237 @@
+/*! \file */
+
+#include "NextionFlowControl.h"
+#include "NextionLogger.h"
+#include <algorithm>
+
+/*!
+ * \brief Creates a flow control for a buffer of NEXTION_DEVICE_BUFFER_SIZE
+ *        bytes and an assumed link of 9600 baud.
+ */
+NextionFlowControl::NextionFlowControl()
+    : m_outstanding(0)
+    , m_bufferSize(NEXTION_DEVICE_BUFFER_SIZE)
+    , m_baudrate(9600)
+    , m_drainRate(0)
+    , m_acknowledged(false)
+    , m_lastDrain(0)
+    , m_stalls(0)
+{
+}
+
+/*!
+ * \brief Sets the size of the serial input buffer of the device.
+ * \param size Size in bytes, 0 to disable flow control
+ */
+void NextionFlowControl::setBufferSize(size_t size)
+{
+    m_bufferSize = size;
+    reset();
+}
+
+/*!
+ * \brief Gets the size of the serial input buffer of the device.
+ * \return Size in bytes, 0 if flow control is disabled
+ */
+size_t NextionFlowControl::getBufferSize() const
+{
+    return m_bufferSize;
+}
+
+/*!
+ * \brief Sets the baud rate the default drain rate is derived from.
+ * \param baudrate Baud rate of the link
+ */
+void NextionFlowControl::setBaudRate(uint32_t baudrate)
+{
+    m_baudrate = baudrate;
+}
+
+/*!
+ * \brief Sets the rate the device consumes commands at when they are not
+ *        acknowledged.
+ * \param rate Bytes per second, 0 for half the byte rate of the link
+ */
+void NextionFlowControl::setDrainRate(uint32_t rate)
+{
+    m_drainRate = rate;
+}
+
+/*!
+ * \brief Sets whether the device replies to every command, i.e. whether
+ *        replies return credit.
+ * \param acknowledged If command results are required
+ */
+void NextionFlowControl::setAcknowledged(bool acknowledged)
+{
+    if (acknowledged != m_acknowledged)
+    {
+        m_acknowledged = acknowledged;
+        reset();
+    }
+}
+
+/*!
+ * \brief Checks if replies return credit.
+ * \return True if commands are acknowledged
+ */
+bool NextionFlowControl::isAcknowledged() const
+{
+    return m_acknowledged;
+}
+
+/*!
+ * \brief Checks if a command fits into the device buffer now.
+ * \param bytes Size of the command (including termination bytes)
+ * \return True if it may be written
+ *
+ * A command larger than the buffer may be written once nothing is outstanding.
+ */
+bool NextionFlowControl::canSend(size_t bytes)
+{
+    if (m_bufferSize == 0)
+    {
+        return true;
+    }
+    drain();
+    return m_outstanding == 0 || m_outstanding + bytes <= m_bufferSize;
+}
+
+/*!
+ * \brief Gets the time until a command fits when credit is returned over time.
+ * \param bytes Size of the command (including termination bytes)
+ * \return Time in us
+ */
+uint32_t NextionFlowControl::getWaitTime(size_t bytes)
+{
+    if (canSend(bytes))
+    {
+        return 0;
+    }
+    size_t excess = bytes > m_bufferSize ? m_outstanding : m_outstanding + bytes - m_bufferSize;
+    return static_cast<uint32_t>(static_cast<uint64_t>(excess) * 1000000 / getEffectiveDrainRate()) + 1;
+}
+
+/*!
+ * \brief Takes the credit of a command written to the device.
+ * \param bytes Size of the command (including termination bytes)
+ */
+void NextionFlowControl::sent(size_t bytes)
+{
+    if (m_bufferSize == 0)
+    {
+        return;
+    }
+    drain();
+    m_commands.push_back(static_cast<uint16_t>(std::min<size_t>(bytes, 0xFFFF)));
+    m_outstanding += m_commands.back();
+}
+
+/*!
+ * \brief Returns the credit of the oldest outstanding command, called for each
+ *        reply received.
+ */
+void NextionFlowControl::acknowledge()
+{
+    if (!m_acknowledged || m_commands.empty())
+    {
+        return;
+    }
+    m_outstanding -= m_commands.front();
+    m_commands.pop_front();
+}
+
+/*!
+ * \brief Assumes the device buffer is empty, e.g. after replies timed out.
+ */
+void NextionFlowControl::reset()
+{
+    m_commands.clear();
+    m_outstanding = 0;
+    m_lastDrain = micros();
+}
+
+/*!
+ * \brief Gets the bytes assumed to be in the device buffer.
+ * \return Number of bytes
+ */
+size_t NextionFlowControl::getOutstanding()
+{
+    drain();
+    return m_outstanding;
+}
+
+/*!
+ * \brief Gets the number of writes that had to wait for credit.
+ * \return Number of writes
+ */
+uint32_t NextionFlowControl::getStallCount() const
+{
+    return m_stalls;
+}
+
+/*!
+ * \brief Counts a write that had to wait for credit.
+ */
+void NextionFlowControl::recordStall()
+{
+    ++m_stalls;
+}
+
+/*!
+ * \brief Returns credit for the time passed, if commands are not acknowledged.
+ */
+void NextionFlowControl::drain()
+{
+    uint32_t now = micros();
+    if (m_acknowledged || m_commands.empty())
+    {
+        m_lastDrain = now;
+        return;
+    }
+
+    uint64_t drained = static_cast<uint64_t>(now - m_lastDrain) * getEffectiveDrainRate() / 1000000;
+    if (drained == 0)
+    {
+        // Keep m_lastDrain so the fraction is not lost
+        return;
+    }
+    m_lastDrain = now;
+    release(drained > m_outstanding ? m_outstanding : static_cast<size_t>(drained));
+}
+
+/*!
+ * \brief Returns credit of outstanding commands, oldest first.
+ * \param bytes Number of bytes consumed by the device
+ */
+void NextionFlowControl::release(size_t bytes)
+{
+    m_outstanding -= bytes;
+    while (bytes > 0 && !m_commands.empty())
+    {
+        if (m_commands.front() <= bytes)
+        {
+            bytes -= m_commands.front();
+            m_commands.pop_front();
+        }
+        else
+        {
+            m_commands.front() -= bytes;
+            bytes = 0;
+        }
+    }
+}
+
+/*!
+ * \brief Gets the rate credit is returned at over time.
+ * \return Bytes per second
+ */
+uint32_t NextionFlowControl::getEffectiveDrainRate() const
+{
+    if (m_drainRate > 0)
+    {
+        return m_drainRate;
+    }
+    // 10 bits per byte, half the link rate
+    return std::max<uint32_t>(m_baudrate / 20, 1);
+}
@@ -0,0 +1,62 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <deque>
+
+#ifndef NEXTION_DEVICE_BUFFER_SIZE
+#define NEXTION_DEVICE_BUFFER_SIZE 1024 //!< Size of the serial input buffer of the device in bytes
+#endif
+
+/*!
+ * \class NextionFlowControl
+ * \brief Models the occupancy of the serial input buffer of the device, so
+ *        writes can be held back before it overflows.
+ *
+ * Every command written takes credit of its size from the device buffer. When
+ * the device acknowledges commands (bkcmd=3) each reply returns the credit of
+ * the oldest outstanding command. Otherwise credit is returned over time at
+ * the drain rate, by default half the byte rate of the link.
+ */
+class NextionFlowControl
+{
+public:
+    NextionFlowControl();
+
+    void setBufferSize(size_t size);
+    size_t getBufferSize() const;
+    void setBaudRate(uint32_t baudrate);
+    void setDrainRate(uint32_t rate);
+    void setAcknowledged(bool acknowledged);
+    bool isAcknowledged() const;
+
+    bool canSend(size_t bytes);
+    uint32_t getWaitTime(size_t bytes);
+    void sent(size_t bytes);
+    void acknowledge();
+    void reset();
+
+    size_t getOutstanding();
+    uint32_t getStallCount() const;
+    void recordStall();
+
+private:
+    std::deque<uint16_t> m_commands; //!< Sizes of the outstanding commands, oldest first
+    size_t m_outstanding;            //!< Bytes of the outstanding commands
+    size_t m_bufferSize;             //!< Size of the device buffer, 0 to disable
+    uint32_t m_baudrate;             //!< Baud rate of the link
+    uint32_t m_drainRate;            //!< Bytes per second the device consumes, 0 for the default
+    bool m_acknowledged;             //!< Whether replies return credit
+    uint32_t m_lastDrain;            //!< micros() when credit was last returned over time
+    uint32_t m_stalls;               //!< Number of writes that had to wait for credit
+
+    void drain();
+    void release(size_t bytes);
+    uint32_t getEffectiveDrainRate() const;
+};
@@ -0,0 +1,350 @@
+/*! \file */
+
+#include "NextionIOTask.h"
+#include "NextionLogger.h"
+
+#ifndef NEXTION_IO_TASK_FREERTOS
+#include <chrono>
+#endif
+
+/*!
+ * \brief States of a NextionCompletion.
+ */
+enum NextionCompletionState
+{
+    NEX_COMPLETION_PENDING = 0,
+    NEX_COMPLETION_SUCCEEDED = 1,
+    NEX_COMPLETION_FAILED = 2
+};
+
+/*!
+ * \brief Gives up the CPU for a short while.
+ */
+static void sleepOneTick()
+{
+#ifdef NEXTION_IO_TASK_FREERTOS
+    vTaskDelay(1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
+
+/*!
+ * \brief Creates a new pending completion.
+ */
+NextionCompletion::NextionCompletion()
+    : m_state(NEX_COMPLETION_PENDING)
+{
+}
+
+/*!
+ * \brief Sets the completion back to pending so it can be reused.
+ */
+void NextionCompletion::reset()
+{
+    m_state.store(NEX_COMPLETION_PENDING, std::memory_order_relaxed);
+}
+
+/*!
+ * \brief Checks if the command has been sent and its result received.
+ * \return True if done
+ */
+bool NextionCompletion::isDone() const
+{
+    return m_state.load(std::memory_order_acquire) != NEX_COMPLETION_PENDING;
+}
+
+/*!
+ * \brief Gets the result of the command.
+ * \return True if the command is done and was successful
+ */
+bool NextionCompletion::getResult() const
+{
+    return m_state.load(std::memory_order_acquire) == NEX_COMPLETION_SUCCEEDED;
+}
+
+/*!
+ * \brief Waits until the command is done.
+ * \param timeout Maximum time to wait in ms
+ * \return True if the command is done and was successful
+ */
+bool NextionCompletion::wait(uint32_t timeout) const
+{
+    uint32_t start = millis();
+    while (!isDone())
+    {
+        if (millis() - start > timeout)
+        {
+            return false;
+        }
+        sleepOneTick();
+    }
+    return getResult();
+}
+
+/*!
+ * \brief Marks the command as done.
+ * \param result If the command was successful
+ */
+void NextionCompletion::complete(bool result)
+{
+    m_state.store(result ? NEX_COMPLETION_SUCCEEDED : NEX_COMPLETION_FAILED, std::memory_order_release);
+}
+
+/*!
+ * \brief Creates a new, stopped I/O task.
+ * \param nex Driver the task will own while running
+ */
+NextionIOTask::NextionIOTask(Nextion &nex)
+    : m_nextion(nex)
+    , m_running(false)
+    , m_stopped(true)
+    , m_rejected(0)
+    , m_submitting(0)
+#ifdef NEXTION_IO_TASK_FREERTOS
+    , m_task(nullptr)
+#endif
+{
+}
+
+/*!
+ * \brief dtor, stops the task.
+ */
+NextionIOTask::~NextionIOTask()
+{
+    stop();
+}
+
+/*!
+ * \brief Starts the task.
+ * \param stackSize Stack size of the task in bytes (FreeRTOS only)
+ * \param priority Priority of the task (FreeRTOS only)
+ * \param core Core to pin the task to, -1 for no affinity (FreeRTOS only)
+ * \return True if successful
+ */
+bool NextionIOTask::start(uint32_t stackSize, uint8_t priority, int8_t core)
+{
+    if (m_running.load())
+    {
+        return false;
+    }
+
+    m_stopped.store(false);
+    m_running.store(true);
+
+#ifdef NEXTION_IO_TASK_FREERTOS
+    TaskHandle_t task = nullptr;
+    BaseType_t created;
+    if (core < 0)
+    {
+        created = xTaskCreate(&NextionIOTask::run, "nextion_io", stackSize, this, priority, &task);
+    }
+    else
+    {
+        created = xTaskCreatePinnedToCore(&NextionIOTask::run, "nextion_io", stackSize, this, priority, &task, core);
+    }
+    if (created != pdPASS)
+    {
+        NextionLog("NextionIOTask::start: Failed to create task.\n");
+        m_running.store(false);
+        m_stopped.store(true);
+        return false;
+    }
+    m_task.store(task);
+#else
+    (void)stackSize;
+    (void)priority;
+    (void)core;
+    m_thread = std::thread(&NextionIOTask::run, this);
+#endif
+    return true;
+}
+
+/*!
+ * \brief Stops the task after the request being processed is done.
+ *
+ * Requests still queued, including those submitted while stopping, are
+ * completed as failed.
+ */
+void NextionIOTask::stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    // Submissions that saw the task running have queued their request once
+    // this returns, later ones are rejected
+    waitForSubmissions();
+
+#ifdef NEXTION_IO_TASK_FREERTOS
+    notify();
+    while (!m_stopped.load())
+    {
+        sleepOneTick();
+    }
+    m_task.store(nullptr);
+#else
+    m_thread.join();
+#endif
+
+    Request request;
+    while (m_queue.pop(request))
+    {
+        if (request.completion)
+        {
+            request.completion->complete(false);
+        }
+    }
+}
+
+/*!
+ * \brief Checks if the task is running.
+ * \return True if running
+ */
+bool NextionIOTask::isRunning() const
+{
+    return m_running.load();
+}
+
+/*!
+ * \brief Submits a command to be sent by the task. May be called from any
+ *        task.
+ * \param command Command to send
+ * \param completion Receives the result of the command, may be null
+ * \return True if the command was queued, false if the task is not running,
+ *         the queue is full or the command is too long
+ */
+bool NextionIOTask::submit(const char *command, NextionCompletion *completion)
+{
+    Request request;
+    size_t length = strlen(command);
+    if (length >= sizeof(request.command))
+    {
+        NextionLog("NextionIOTask::submit: Command too long: %u\n", length);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    memcpy(request.command, command, length + 1);
+    request.completion = completion;
+
+    // Counted before checking m_running, so stop() either waits for the
+    // request to be queued or this sees the task stopping
+    m_submitting.fetch_add(1);
+    bool queued = m_running.load() && m_queue.push(request);
+    if (queued)
+    {
+        notify();
+    }
+    m_submitting.fetch_sub(1);
+
+    if (!queued)
+    {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+    return queued;
+}
+
+/*!
+ * \brief Formats and submits a command to be sent by the task. May be called
+ *        from any task.
+ * \param completion Receives the result of the command, may be null
+ * \param format Format string
+ * \return True if the command was queued
+ */
+bool NextionIOTask::submitf(NextionCompletion *completion, const char *format, ...)
+{
+    char command[NEXTION_IO_TASK_COMMAND_SIZE];
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(command, sizeof(command), format, args);
+    va_end(args);
+    if (written < 0 || written >= static_cast<int>(sizeof(command)))
+    {
+        NextionLog("NextionIOTask::submitf: Failed to format the command.\n");
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return submit(command, completion);
+}
+
+/*!
+ * \brief Gets the number of submissions rejected because the queue was full
+ *        or the command too long.
+ * \return Number of rejected commands
+ */
+uint32_t NextionIOTask::getRejectedCount() const
+{
+    return m_rejected.load(std::memory_order_relaxed);
+}
+
+/*!
+ * \brief Entry point of the task.
+ * \param arg The NextionIOTask
+ */
+void NextionIOTask::run(void *arg)
+{
+    NextionIOTask *task = static_cast<NextionIOTask *>(arg);
+    task->loop();
+    // Submissions may still be notifying this task
+    task->waitForSubmissions();
+    task->m_stopped.store(true);
+#ifdef NEXTION_IO_TASK_FREERTOS
+    vTaskDelete(nullptr);
+#endif
+}
+
+/*!
+ * \brief Sends submitted commands and polls the device until stopped.
+ */
+void NextionIOTask::loop()
+{
+    Request request;
+    while (m_running.load())
+    {
+        while (m_queue.pop(request))
+        {
+            m_nextion.sendCommand(request.command, strlen(request.command));
+            bool result = m_nextion.checkCommandComplete();
+            if (request.completion)
+            {
+                request.completion->complete(result);
+            }
+        }
+
+        m_nextion.poll();
+
+#ifdef NEXTION_IO_TASK_FREERTOS
+        // Sleep until a submission arrives, but at least poll once per tick
+        ulTaskNotifyTake(pdTRUE, 1);
+#else
+        sleepOneTick();
+#endif
+    }
+}
+
+/*!
+ * \brief Wakes the task up after a submission.
+ */
+void NextionIOTask::notify()
+{
+#ifdef NEXTION_IO_TASK_FREERTOS
+    TaskHandle_t task = m_task.load();
+    if (task)
+    {
+        xTaskNotifyGive(task);
+    }
+#endif
+}
+
+/*!
+ * \brief Waits until no submission is in progress.
+ */
+void NextionIOTask::waitForSubmissions() const
+{
+    while (m_submitting.load() > 0)
+    {
+        sleepOneTick();
+    }
+}
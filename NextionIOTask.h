@@ -0,0 +1,109 @@
+/*! \file */
+
+#pragma once
+
+#include <atomic>
+
+#include "Nextion.h"
+#include "NextionRingBuffer.h"
+
+// Define to use std::thread on ESP32 as well, e.g. when the pthread layer of
+// ESP-IDF is preferred over native FreeRTOS tasks
+//#define NEXTION_IO_TASK_USE_STD_THREAD
+
+#if defined(ESP32) && !defined(NEXTION_IO_TASK_USE_STD_THREAD)
+#define NEXTION_IO_TASK_FREERTOS
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+#ifndef NEXTION_IO_TASK_QUEUE_LENGTH
+#define NEXTION_IO_TASK_QUEUE_LENGTH 16 //!< Number of pending requests, power of two
+#endif
+
+#ifndef NEXTION_IO_TASK_COMMAND_SIZE
+#define NEXTION_IO_TASK_COMMAND_SIZE 96 //!< Maximum command length including null character
+#endif
+
+/*!
+ * \class NextionCompletion
+ * \brief Receives the result of a command submitted to a NextionIOTask.
+ *
+ * Must stay alive until the command is done.
+ */
+class NextionCompletion
+{
+public:
+    NextionCompletion();
+
+    void reset();
+    bool isDone() const;
+    bool getResult() const;
+    bool wait(uint32_t timeout = 1000) const;
+
+private:
+    friend class NextionIOTask;
+
+    void complete(bool result);
+
+    std::atomic<uint8_t> m_state; //!< Pending, succeeded or failed
+};
+
+/*!
+ * \class NextionIOTask
+ * \brief Runs a Nextion driver on a dedicated task.
+ *
+ * Once started the task is the only user of the driver (and its serial port):
+ * it sends submitted commands, waits for their results and calls
+ * Nextion::poll(), so touch callbacks run on the task as well. Other tasks must
+ * not call the driver directly, but may submit commands concurrently from any
+ * number of tasks.
+ *
+ * Uses a FreeRTOS task on ESP32 and std::thread elsewhere (e.g. when testing on
+ * Linux).
+ */
+class NextionIOTask
+{
+public:
+    NextionIOTask(Nextion &nex);
+    ~NextionIOTask();
+
+    bool start(uint32_t stackSize = 4096, uint8_t priority = 1, int8_t core = -1);
+    void stop();
+    bool isRunning() const;
+
+    bool submit(const char *command, NextionCompletion *completion = nullptr);
+    bool submitf(NextionCompletion *completion, const char *format, ...);
+
+    uint32_t getRejectedCount() const;
+
+private:
+    /*!
+     * \struct Request
+     * \brief A command waiting to be sent by the task.
+     */
+    struct Request
+    {
+        char command[NEXTION_IO_TASK_COMMAND_SIZE]; //!< Null terminated command
+        NextionCompletion *completion;              //!< Result receiver, may be null
+    };
+
+    static void run(void *arg);
+    void loop();
+    void notify();
+    void waitForSubmissions() const;
+
+    Nextion &m_nextion; //!< Driver owned by the task while running
+    NextionRingBuffer<Request, NEXTION_IO_TASK_QUEUE_LENGTH> m_queue;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopped;
+    std::atomic<uint32_t> m_rejected;
+    std::atomic<uint32_t> m_submitting; //!< Number of submissions in progress
+#ifdef NEXTION_IO_TASK_FREERTOS
+    std::atomic<TaskHandle_t> m_task;
+#else
+    std::thread m_thread;
+#endif
+};
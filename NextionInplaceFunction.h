@@ -0,0 +1,180 @@
+/*! \file */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, std::size_t Capacity>
+class NextionInplaceFunction;
+
+/*!
+ * \class NextionInplaceFunction
+ * \brief Callable wrapper storing its target inside the object itself.
+ *
+ * Works like std::function, but never allocates: targets larger than Capacity
+ * bytes are rejected at compile time.
+ *
+ * \tparam R Return type
+ * \tparam Args Argument types
+ * \tparam Capacity Storage size in bytes for the target
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class NextionInplaceFunction<R(Args...), Capacity>
+{
+public:
+    NextionInplaceFunction()
+        : m_invoke(nullptr)
+        , m_manage(nullptr)
+    {
+    }
+
+    NextionInplaceFunction(std::nullptr_t)
+        : m_invoke(nullptr)
+        , m_manage(nullptr)
+    {
+    }
+
+    /*!
+     * \brief Creates a wrapper around a callable.
+     * \param target Function pointer, functor or lambda
+     */
+    template <typename F,
+              typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, NextionInplaceFunction>::value>::type>
+    NextionInplaceFunction(F &&target)
+        : m_invoke(nullptr)
+        , m_manage(nullptr)
+    {
+        assign(std::forward<F>(target));
+    }
+
+    NextionInplaceFunction(const NextionInplaceFunction &other)
+        : m_invoke(nullptr)
+        , m_manage(nullptr)
+    {
+        copyFrom(other);
+    }
+
+    ~NextionInplaceFunction()
+    {
+        reset();
+    }
+
+    NextionInplaceFunction &operator=(const NextionInplaceFunction &other)
+    {
+        if (this != &other)
+        {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    NextionInplaceFunction &operator=(std::nullptr_t)
+    {
+        reset();
+        return *this;
+    }
+
+    /*!
+     * \brief Checks if a target is set.
+     * \return True if callable
+     */
+    explicit operator bool() const
+    {
+        return m_invoke != nullptr;
+    }
+
+    /*!
+     * \brief Calls the target, which must be set.
+     */
+    R operator()(Args... args) const
+    {
+        return m_invoke(&m_storage, std::forward<Args>(args)...);
+    }
+
+private:
+    typedef R (*InvokeFunction)(const void *storage, Args... args);
+    typedef void (*ManageFunction)(void *destination, const void *source);
+
+    template <typename F>
+    void assign(F &&target)
+    {
+        typedef typename std::decay<F>::type Target;
+        static_assert(sizeof(Target) <= Capacity, "Callable does not fit in NextionInplaceFunction");
+        static_assert(alignof(Target) <= alignof(Storage), "Callable is over aligned for NextionInplaceFunction");
+
+        if (isNull(target))
+        {
+            return;
+        }
+
+        new (&m_storage) Target(std::forward<F>(target));
+        m_invoke = &invokeTarget<Target>;
+        m_manage = &manageTarget<Target>;
+    }
+
+    void copyFrom(const NextionInplaceFunction &other)
+    {
+        if (other.m_manage)
+        {
+            other.m_manage(&m_storage, &other.m_storage);
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+        }
+    }
+
+    void reset()
+    {
+        if (m_manage)
+        {
+            m_manage(nullptr, &m_storage);
+        }
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+
+    template <typename Target>
+    static R invokeTarget(const void *storage, Args... args)
+    {
+        return (*const_cast<Target *>(static_cast<const Target *>(storage)))(std::forward<Args>(args)...);
+    }
+
+    /*!
+     * \brief Copies the target into destination, or destroys it if destination
+     *        is null.
+     */
+    template <typename Target>
+    static void manageTarget(void *destination, const void *source)
+    {
+        const Target *target = static_cast<const Target *>(source);
+        if (destination)
+        {
+            new (destination) Target(*target);
+        }
+        else
+        {
+            target->~Target();
+        }
+    }
+
+    template <typename T>
+    static bool isNull(T *pointer)
+    {
+        return pointer == nullptr;
+    }
+
+    template <typename T>
+    static bool isNull(const T &)
+    {
+        return false;
+    }
+
+    typedef typename std::aligned_storage<Capacity, alignof(void *)>::type Storage;
+
+    Storage m_storage;       //!< Storage of the target
+    InvokeFunction m_invoke; //!< Calls the target, null if empty
+    ManageFunction m_manage; //!< Copies/destroys the target, null if empty
+};
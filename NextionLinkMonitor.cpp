@@ -0,0 +1,323 @@
+/*! \file */
+
+#include "NextionLinkMonitor.h"
+#include "NextionLogger.h"
+#include <algorithm>
+
+/*!
+ * \brief Factor the latency percentile is multiplied by to get the timeout.
+ */
+static const uint32_t LATENCY_MARGIN = 2;
+
+/*!
+ * \brief Creates a new monitor for an assumed link of 9600 baud.
+ * \param maxTimeout Longest time to wait for a reply in ms
+ */
+NextionLinkMonitor::NextionLinkMonitor(uint32_t maxTimeout)
+    : m_sampleCount(0)
+    , m_nextSample(0)
+    , m_latency(0)
+    , m_baudrate(9600)
+    , m_adaptive(true)
+    , m_maxTimeout(maxTimeout)
+    , m_minTimeout(20)
+    , m_percentile(95)
+    , m_failureThreshold(3)
+    , m_failures(0)
+    , m_state(NEX_LINK_UNKNOWN)
+    , m_probeInterval(1000)
+    , m_probeTimeout(100)
+    , m_lastProbe(0)
+    , m_probing(false)
+    , m_timeouts(0)
+    , m_fastFails(0)
+{
+}
+
+/*!
+ * \brief Sets the baud rate transmit times are calculated from.
+ * \param baudrate Baud rate of the serial link
+ */
+void NextionLinkMonitor::setBaudRate(uint32_t baudrate)
+{
+    m_baudrate = baudrate;
+}
+
+/*!
+ * \brief Sets whether timeouts are adapted to the observed latencies.
+ * \param adaptive If false the maximum timeout is always used, e.g. for long
+ *                 running commands
+ *
+ * Fast failing of a dead link is not affected.
+ */
+void NextionLinkMonitor::setAdaptive(bool adaptive)
+{
+    m_adaptive = adaptive;
+}
+
+/*!
+ * \brief Sets the longest time to wait for a reply.
+ * \param timeout Timeout in ms
+ */
+void NextionLinkMonitor::setMaxTimeout(uint32_t timeout)
+{
+    m_maxTimeout = timeout;
+}
+
+/*!
+ * \brief Sets the shortest adapted timeout.
+ * \param timeout Timeout in ms
+ */
+void NextionLinkMonitor::setMinTimeout(uint32_t timeout)
+{
+    m_minTimeout = timeout;
+}
+
+/*!
+ * \brief Sets the percentile of recent latencies adapted timeouts are based
+ *        on.
+ * \param percentile Percentile (1 to 100)
+ */
+void NextionLinkMonitor::setPercentile(uint8_t percentile)
+{
+    m_percentile = std::max<uint8_t>(1, std::min<uint8_t>(percentile, 100));
+    m_latency = calcPercentile(m_percentile);
+}
+
+/*!
+ * \brief Sets the number of consecutive timeouts after which the link is
+ *        considered dead.
+ * \param failures Number of timeouts, 0 to never fail fast
+ */
+void NextionLinkMonitor::setFailureThreshold(uint8_t failures)
+{
+    m_failureThreshold = failures;
+}
+
+/*!
+ * \brief Sets how a dead link is probed.
+ * \param interval Time between probes in ms, 0 to only probe on request
+ * \param timeout Time to wait for the reply to a probe in ms
+ */
+void NextionLinkMonitor::setProbing(uint32_t interval, uint32_t timeout)
+{
+    m_probeInterval = interval;
+    m_probeTimeout = timeout;
+}
+
+/*!
+ * \brief Gets the time to wait for the reply to a command.
+ * \param bytes Size of the command (including termination bytes)
+ * \param slow Whether the device takes long to execute the command (e.g. page,
+ *             ref or rest), its reply latency says nothing about the link
+ * \return Timeout in ms, 0 if the link is dead
+ */
+uint32_t NextionLinkMonitor::getTimeout(size_t bytes, bool slow) const
+{
+    if (m_state == NEX_LINK_DEAD)
+    {
+        return m_probing ? m_probeTimeout : 0;
+    }
+    if (slow || !m_adaptive || m_failures > 0 || m_sampleCount < NEXTION_LINK_MIN_SAMPLES)
+    {
+        return m_maxTimeout;
+    }
+
+    uint32_t timeout = (getTransmitTime(bytes) + m_latency * LATENCY_MARGIN + 999) / 1000;
+    return std::min(std::max(timeout, m_minTimeout), m_maxTimeout);
+}
+
+/*!
+ * \brief Gets the time needed to transmit bytes at the current baud rate.
+ * \param bytes Number of bytes
+ * \return Time in us
+ */
+uint32_t NextionLinkMonitor::getTransmitTime(size_t bytes) const
+{
+    // 10 bits per byte (start, 8 data, stop)
+    return static_cast<uint32_t>(static_cast<uint64_t>(bytes) * 10 * 1000000 / m_baudrate);
+}
+
+/*!
+ * \brief Records a reply to a command.
+ * \param latency Time between the command being transmitted and the reply
+ *                arriving in us
+ */
+void NextionLinkMonitor::recordReply(uint32_t latency)
+{
+    m_samples[m_nextSample] = latency;
+    m_nextSample = (m_nextSample + 1) % NEXTION_LINK_LATENCY_SAMPLES;
+    if (m_sampleCount < NEXTION_LINK_LATENCY_SAMPLES)
+    {
+        ++m_sampleCount;
+    }
+    m_latency = calcPercentile(m_percentile);
+    recordActivity();
+}
+
+/*!
+ * \brief Records a message received from the device whose latency is not
+ *        known, e.g. a touch event.
+ */
+void NextionLinkMonitor::recordActivity()
+{
+    m_failures = 0;
+    setState(NEX_LINK_ALIVE);
+}
+
+/*!
+ * \brief Records a read that timed out or failed fast.
+ */
+void NextionLinkMonitor::recordTimeout()
+{
+    if (m_state == NEX_LINK_DEAD && !m_probing)
+    {
+        ++m_fastFails;
+        return;
+    }
+
+    ++m_timeouts;
+    if (m_failures < 0xFF)
+    {
+        ++m_failures;
+    }
+    if (m_failureThreshold > 0 && m_failures >= m_failureThreshold)
+    {
+        setState(NEX_LINK_DEAD);
+    }
+}
+
+/*!
+ * \brief Checks if a dead link should be probed now.
+ * \return True if a probe is due
+ */
+bool NextionLinkMonitor::isProbeDue() const
+{
+    return m_state == NEX_LINK_DEAD && m_probeInterval > 0 && !m_probing &&
+           millis() - m_lastProbe >= m_probeInterval;
+}
+
+/*!
+ * \brief Marks the start of a probe, reads wait for the probe timeout even if
+ *        the link is dead.
+ */
+void NextionLinkMonitor::beginProbe()
+{
+    m_probing = true;
+    m_lastProbe = millis();
+}
+
+/*!
+ * \brief Marks the end of a probe.
+ */
+void NextionLinkMonitor::endProbe()
+{
+    m_probing = false;
+}
+
+/*!
+ * \brief Gets the health of the link.
+ * \return State of the link
+ */
+NextionLinkState NextionLinkMonitor::getState() const
+{
+    return m_state;
+}
+
+/*!
+ * \brief Checks if the link is not known to be dead.
+ * \return True if commands wait for their replies
+ */
+bool NextionLinkMonitor::isAlive() const
+{
+    return m_state != NEX_LINK_DEAD;
+}
+
+/*!
+ * \brief Gets the latency percentile adapted timeouts are based on.
+ * \return Latency in us, 0 if no reply was recorded
+ */
+uint32_t NextionLinkMonitor::getLatency() const
+{
+    return m_latency;
+}
+
+/*!
+ * \brief Gets a percentile of recent reply latencies.
+ * \param percentile Percentile (1 to 100)
+ * \return Latency in us, 0 if no reply was recorded
+ */
+uint32_t NextionLinkMonitor::getLatencyPercentile(uint8_t percentile) const
+{
+    return calcPercentile(percentile);
+}
+
+/*!
+ * \brief Gets the number of reads that timed out while waiting.
+ * \return Number of timeouts
+ */
+uint32_t NextionLinkMonitor::getTimeoutCount() const
+{
+    return m_timeouts;
+}
+
+/*!
+ * \brief Gets the number of reads that failed without waiting because the link
+ *        was dead.
+ * \return Number of reads
+ */
+uint32_t NextionLinkMonitor::getFastFailCount() const
+{
+    return m_fastFails;
+}
+
+/*!
+ * \brief Clears the recorded latencies and counters. The state of the link is
+ *        kept.
+ */
+void NextionLinkMonitor::resetStatistics()
+{
+    m_sampleCount = 0;
+    m_nextSample = 0;
+    m_latency = 0;
+    m_timeouts = 0;
+    m_fastFails = 0;
+}
+
+/*!
+ * \brief Changes the state of the link.
+ * \param state New state
+ */
+void NextionLinkMonitor::setState(NextionLinkState state)
+{
+    if (state == m_state)
+    {
+        return;
+    }
+
+    NextionLog("NextionLinkMonitor::setState: Link state %u -> %u\n", m_state, state);
+    if (state == NEX_LINK_DEAD)
+    {
+        m_lastProbe = millis();
+    }
+    m_state = state;
+}
+
+/*!
+ * \brief Calculates a percentile of the recorded latencies.
+ * \param percentile Percentile (1 to 100)
+ * \return Latency in us, 0 if no reply was recorded
+ */
+uint32_t NextionLinkMonitor::calcPercentile(uint8_t percentile) const
+{
+    if (m_sampleCount == 0)
+    {
+        return 0;
+    }
+
+    uint32_t sorted[NEXTION_LINK_LATENCY_SAMPLES];
+    std::copy(m_samples, m_samples + m_sampleCount, sorted);
+    size_t index = (m_sampleCount - 1) * std::min<uint8_t>(percentile, 100) / 100;
+    std::nth_element(sorted, sorted + index, sorted + m_sampleCount);
+    return sorted[index];
+}
@@ -0,0 +1,90 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include "NextionTypes.h"
+
+#ifndef NEXTION_LINK_LATENCY_SAMPLES
+#define NEXTION_LINK_LATENCY_SAMPLES 32 //!< Number of reply latencies timeouts are derived from
+#endif
+
+#ifndef NEXTION_LINK_MIN_SAMPLES
+#define NEXTION_LINK_MIN_SAMPLES 8 //!< Replies needed before timeouts are adapted
+#endif
+
+/*!
+ * \class NextionLinkMonitor
+ * \brief Derives reply timeouts from observed latencies and tracks the health
+ *        of the link.
+ *
+ * The timeout of a read is the transmit time of the command at the current
+ * baud rate plus a multiple of a percentile of recent reply latencies, limited
+ * to the maximum timeout. After a timeout the maximum is used until a reply
+ * arrives, so a slow command is not mistaken for a dead link. Commands the
+ * device takes long to execute (e.g. page) always get the maximum timeout.
+ *
+ * After several consecutive timeouts the link is considered dead and reads
+ * fail immediately, so a disconnected device no longer stalls every command.
+ * Nextion::poll() probes the device periodically and any message received
+ * marks the link alive again.
+ */
+class NextionLinkMonitor
+{
+public:
+    NextionLinkMonitor(uint32_t maxTimeout = 1000);
+
+    void setBaudRate(uint32_t baudrate);
+    void setAdaptive(bool adaptive);
+    void setMaxTimeout(uint32_t timeout);
+    void setMinTimeout(uint32_t timeout);
+    void setPercentile(uint8_t percentile);
+    void setFailureThreshold(uint8_t failures);
+    void setProbing(uint32_t interval, uint32_t timeout = 100);
+
+    uint32_t getTimeout(size_t bytes, bool slow = false) const;
+    uint32_t getTransmitTime(size_t bytes) const;
+
+    void recordReply(uint32_t latency);
+    void recordActivity();
+    void recordTimeout();
+    bool isProbeDue() const;
+    void beginProbe();
+    void endProbe();
+
+    NextionLinkState getState() const;
+    bool isAlive() const;
+    uint32_t getLatency() const;
+    uint32_t getLatencyPercentile(uint8_t percentile) const;
+    uint32_t getTimeoutCount() const;
+    uint32_t getFastFailCount() const;
+    void resetStatistics();
+
+private:
+    uint32_t m_samples[NEXTION_LINK_LATENCY_SAMPLES]; //!< Ring of recent reply latencies in us
+    size_t m_sampleCount;                             //!< Number of valid entries in m_samples
+    size_t m_nextSample;                              //!< Index the next latency is stored at
+    uint32_t m_latency;                               //!< Cached percentile of the latencies in us
+    uint32_t m_baudrate;                              //!< Baud rate of the link
+    bool m_adaptive;                                  //!< Whether timeouts are adapted
+    uint32_t m_maxTimeout;                            //!< Longest timeout in ms
+    uint32_t m_minTimeout;                            //!< Shortest adapted timeout in ms
+    uint8_t m_percentile;                             //!< Percentile of latencies timeouts use
+    uint8_t m_failureThreshold;                       //!< Consecutive timeouts until the link is dead
+    uint8_t m_failures;                               //!< Consecutive timeouts
+    NextionLinkState m_state;                         //!< Current health of the link
+    uint32_t m_probeInterval;                         //!< Time between probes of a dead link in ms
+    uint32_t m_probeTimeout;                          //!< Timeout of probes in ms
+    uint32_t m_lastProbe;                             //!< millis() at the last probe
+    bool m_probing;                                   //!< Whether a probe is in progress
+    uint32_t m_timeouts;                              //!< Number of timeouts
+    uint32_t m_fastFails;                             //!< Number of reads failed without waiting
+
+    void setState(NextionLinkState state);
+    uint32_t calcPercentile(uint8_t percentile) const;
+};
@@ -16,7 +16,12 @@ NextionPage::NextionPage(Nextion &nex, uint8_t page, uint8_t component, const St
  */
 bool NextionPage::show()
 {
-    return sendCommandWithWait("page %s", m_name.c_str());
+    if (sendCommandWithWait("page %s", m_name.c_str()))
+    {
+        m_nextion.notifyPageChanged(m_pageID);
+        return true;
+    }
+    return false;
 }
 
 /*!
@@ -0,0 +1,186 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include "NextionTypes.h"
+
+/*!
+ * \class NextionResult
+ * \brief Result of a command, the exact code returned by the device or a
+ *        timeout.
+ */
+class NextionResult
+{
+public:
+    /*!
+     * \brief Creates a result received from the device.
+     * \param code Returned code
+     */
+    NextionResult(NextionValue code = NEX_RET_CMD_FINISHED)
+        : m_code(code)
+        , m_timedOut(false)
+    {
+    }
+
+    /*!
+     * \brief Creates the result of a command whose reply was not received.
+     * \return Result
+     */
+    static NextionResult timeout()
+    {
+        NextionResult result(NEX_RET_CMD_FAILED);
+        result.m_timedOut = true;
+        return result;
+    }
+
+    /*!
+     * \brief Checks if the command was successful.
+     * \return True if successful
+     */
+    bool isSuccess() const
+    {
+        return !m_timedOut && m_code == NEX_RET_CMD_FINISHED;
+    }
+
+    /*!
+     * \brief Checks if the reply was not received.
+     * \return True if timed out
+     */
+    bool isTimeout() const
+    {
+        return m_timedOut;
+    }
+
+    /*!
+     * \brief Checks if the command may succeed when sent again, i.e. it timed
+     *        out or the serial buffer of the device overflowed.
+     * \return True if the failure is transient
+     */
+    bool isTransient() const
+    {
+        return m_timedOut || m_code == NEX_RET_SERIAL_BUFFER_OVERFLOW;
+    }
+
+    /*!
+     * \brief Gets the code returned by the device.
+     * \return Code, only meaningful if isTimeout() is false
+     */
+    NextionValue getCode() const
+    {
+        return m_code;
+    }
+
+    /*!
+     * \brief Gets the name of the result, e.g. for logging.
+     * \return Name of the code
+     */
+    const char *getName() const
+    {
+        if (m_timedOut)
+        {
+            return "TIMEOUT";
+        }
+
+        switch (m_code)
+        {
+        case NEX_RET_CMD_FAILED:
+            return "NEX_RET_CMD_FAILED";
+        case NEX_RET_CMD_FINISHED:
+            return "NEX_RET_CMD_FINISHED";
+        case NEX_RET_INVALID_COMPONENT_ID:
+            return "NEX_RET_INVALID_COMPONENT_ID";
+        case NEX_RET_INVALID_PAGE_ID:
+            return "NEX_RET_INVALID_PAGE_ID";
+        case NEX_RET_INVALID_PICTURE_ID:
+            return "NEX_RET_INVALID_PICTURE_ID";
+        case NEX_RET_INVALID_FONT_ID:
+            return "NEX_RET_INVALID_FONT_ID";
+        case NEX_RET_INVALID_FILE_OP:
+            return "NEX_RET_INVALID_FILE_OP";
+        case NEX_RET_INVALID_CRC:
+            return "NEX_RET_INVALID_CRC";
+        case NEX_RET_INVALID_BAUD:
+            return "NEX_RET_INVALID_BAUD";
+        case NEX_RET_INVALID_WAVEFORM_ID_CHANNEL:
+            return "NEX_RET_INVALID_WAVEFORM_ID_CHANNEL";
+        case NEX_RET_INVALID_VARIABLE:
+            return "NEX_RET_INVALID_VARIABLE";
+        case NEX_RET_INVALID_OPERATION:
+            return "NEX_RET_INVALID_OPERATION";
+        case NEX_RET_FAILED_TO_ASSIGN:
+            return "NEX_RET_FAILED_TO_ASSIGN";
+        case NEX_RET_EEPROM_OP_FAILED:
+            return "NEX_RET_EEPROM_OP_FAILED";
+        case NEX_RET_INVALID_NUM_PARAMS:
+            return "NEX_RET_INVALID_NUM_PARAMS";
+        case NEX_RET_IO_OP_FAILED:
+            return "NEX_RET_IO_OP_FAILED";
+        case NEX_RET_INVALID_ESCAPE_CHAR:
+            return "NEX_RET_INVALID_ESCAPE_CHAR";
+        case NEX_RET_VAR_NAME_TOO_LONG:
+            return "NEX_RET_VAR_NAME_TOO_LONG";
+        case NEX_RET_SERIAL_BUFFER_OVERFLOW:
+            return "NEX_RET_SERIAL_BUFFER_OVERFLOW";
+        default:
+            return "Unexpected response";
+        }
+    }
+
+    /*!
+     * \brief Checks if the command was successful.
+     * \return True if successful
+     */
+    explicit operator bool() const
+    {
+        return isSuccess();
+    }
+
+private:
+    NextionValue m_code; //!< Code returned by the device
+    bool m_timedOut;     //!< Whether the reply was not received
+};
+
+/*!
+ * \struct NextionRetryPolicy
+ * \brief Decides how commands failing with a transient result are sent again.
+ *
+ * The wait before each further attempt starts at initialBackoff and is
+ * multiplied by backoffFactor up to maxBackoff. Each buffer overflow also
+ * widens the gap kept between writes by throttleStep, up to maxThrottle; each
+ * success narrows it again by an eighth.
+ *
+ * A timeout only means the result was late, not that the command was lost, so
+ * retrying on timeout may run a command twice. Only enable retryOnTimeout if
+ * every command sent is an idempotent assignment (e.g. n0.val=5), never with
+ * commands such as add, cle, click, xstr or sys0=sys0+1.
+ */
+struct NextionRetryPolicy
+{
+    uint8_t maxAttempts;     //!< Attempts per command including the first, 1 to never retry
+    uint32_t initialBackoff; //!< Wait before the first retry in ms
+    uint8_t backoffFactor;   //!< Factor the wait grows by per retry
+    uint32_t maxBackoff;     //!< Longest wait before a retry in ms
+    bool retryOnTimeout;     //!< Whether commands whose reply timed out are sent again, only safe for idempotent commands
+    uint32_t throttleStep;   //!< Gap added between writes per buffer overflow in us, 0 to never throttle
+    uint32_t maxThrottle;    //!< Largest gap between writes in us
+
+    /*!
+     * \brief Creates a policy that never retries and never throttles.
+     */
+    NextionRetryPolicy()
+        : maxAttempts(1)
+        , initialBackoff(10)
+        , backoffFactor(2)
+        , maxBackoff(200)
+        , retryOnTimeout(false)
+        , throttleStep(0)
+        , maxThrottle(20000)
+    {
+    }
+};
@@ -0,0 +1,143 @@
+/*! \file */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/*!
+ * \class NextionRingBuffer
+ * \brief Bounded lock-free queue that may be used by several producers and
+ *        consumers at once.
+ *
+ * Each cell carries a sequence number telling producers and consumers whether
+ * it is free or holds an item, so no locks are needed. Never allocates after
+ * construction.
+ *
+ * \tparam T Item type, must be copy assignable
+ * \tparam N Capacity, must be a power of two
+ */
+template <typename T, std::size_t N>
+class NextionRingBuffer
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    NextionRingBuffer()
+        : m_head(0)
+        , m_tail(0)
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /*!
+     * \brief Adds an item to the queue.
+     * \param item Item to add
+     * \return True if successful, false if the queue is full
+     */
+    bool push(const T &item)
+    {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &m_cells[pos & (N - 1)];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->item = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * \brief Removes the oldest item from the queue.
+     * \param item Removed item
+     * \return True if successful, false if the queue is empty
+     */
+    bool pop(T &item)
+    {
+        std::size_t pos = m_head.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &m_cells[pos & (N - 1)];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = cell->item;
+        cell->sequence.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * \brief Gets the number of items in the queue.
+     * \return Number of items, only approximate while other threads use the
+     *         queue
+     */
+    std::size_t size() const
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    /*!
+     * \brief Gets the capacity of the queue.
+     * \return Maximum number of items
+     */
+    static constexpr std::size_t capacity()
+    {
+        return N;
+    }
+
+private:
+    /*!
+     * \struct Cell
+     * \brief Storage for one item.
+     */
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence; //!< Free/full marker of the cell
+        T item;                            //!< Stored item
+    };
+
+    Cell m_cells[N];
+    std::atomic<std::size_t> m_head; //!< Position of the next item to pop
+    std::atomic<std::size_t> m_tail; //!< Position of the next item to push
+};
@@ -11,9 +11,23 @@ NextionSlider::NextionSlider(Nextion &nex, uint8_t page, uint8_t component,
     , INextionTouchable(nex, page, component, name)
     , INextionColourable(nex, page, component, name)
     , INextionNumericalValued(nex, page, component, name)
+    , m_trackingInterval(0)
+    , m_lastDelivery(0)
+    , m_lastDelivered(0)
+    , m_delivered(false)
+    , m_pendingValue(0)
+    , m_pending(false)
 {
 }
 
+/*!
+ * \brief dtor, disables tracking.
+ */
+NextionSlider::~NextionSlider()
+{
+    disableTracking();
+}
+
 /*!
  * \brief Gets the minimum value.
  * \param value Value
@@ -53,3 +67,116 @@ bool NextionSlider::setMaxValue(uint32_t value)
 {
     return setNumberProperty("maxval", value);
 }
+
+/*!
+ * \brief Enables tracking mode, in which the value is pushed by the display
+ *        during a drag.
+ * \param callback Receives the tracked values
+ * \param minInterval Minimum time between two values delivered during a drag
+ *                    in ms; values arriving faster are coalesced, the latest
+ *                    is delivered by Nextion::poll() once the interval passed
+ * \return True if successful
+ *
+ * The event code returned by getTrackingEventCode() has to be added to the
+ * Touch Move and Touch Release events of the slider in the Nextion Editor. The
+ * value sent on release is always delivered, with final set.
+ */
+bool NextionSlider::setTracking(const TrackingCallback &callback, uint32_t minInterval)
+{
+    if (!callback)
+    {
+        return false;
+    }
+
+    m_trackingCallback = callback;
+    m_trackingInterval = minInterval;
+    if (!m_tracking)
+    {
+        m_nextion.registerPollListener(this);
+        m_tracking.reset(new NextionValueSubscription(*this));
+        m_tracking->attachCallback([this](NextionValueSubscription *subscription, uint32_t value) {
+            trackValue(value, subscription->isFinal());
+        });
+    }
+    return true;
+}
+
+/*!
+ * \brief Disables tracking mode.
+ */
+void NextionSlider::disableTracking()
+{
+    if (m_tracking)
+    {
+        m_nextion.unregisterPollListener(this);
+    }
+    m_tracking.reset();
+    m_trackingCallback = nullptr;
+    m_pending = false;
+}
+
+/*!
+ * \brief Checks if tracking mode is enabled.
+ * \return True if tracking
+ */
+bool NextionSlider::isTracking() const
+{
+    return m_tracking != nullptr;
+}
+
+/*!
+ * \brief Gets the event code sending the value in tracking mode.
+ * \param release True for the code of the Touch Release event, false for the
+ *                Touch Move event
+ * \return Event code, one instruction per line
+ */
+String NextionSlider::getTrackingEventCode(bool release) const
+{
+    return NextionValueSubscription::makeEventCode(const_cast<NextionSlider &>(*this), "val", release);
+}
+
+/*!
+ * \brief Delivers the latest value held back during a drag once the interval
+ *        has passed, called by Nextion::poll().
+ */
+void NextionSlider::polled()
+{
+    if (m_pending && millis() - m_lastDelivery >= m_trackingInterval)
+    {
+        deliverValue(m_pendingValue, false);
+    }
+}
+
+/*!
+ * \brief Delivers a tracked value, limiting the rate during a drag.
+ * \param value Value received
+ * \param final If the value was sent on release
+ */
+void NextionSlider::trackValue(uint32_t value, bool final)
+{
+    if (!final && m_delivered && (millis() - m_lastDelivery < m_trackingInterval || value == m_lastDelivered))
+    {
+        // Held back until polled() once the interval has passed, unless a
+        // newer value arrives first
+        m_pendingValue = value;
+        m_pending = value != m_lastDelivered;
+        return;
+    }
+
+    deliverValue(value, final);
+}
+
+/*!
+ * \brief Passes a tracked value to the callback.
+ * \param value Value to deliver
+ * \param final If the value was sent on release
+ */
+void NextionSlider::deliverValue(uint32_t value, bool final)
+{
+    m_lastDelivery = millis();
+    m_lastDelivered = value;
+    m_pending = false;
+    // The first value of the next drag is delivered immediately
+    m_delivered = !final;
+    m_trackingCallback(this, value, final);
+}
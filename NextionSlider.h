@@ -2,25 +2,73 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include "INextionColourable.h"
 #include "INextionNumericalValued.h"
+#include "INextionPollListener.h"
 #include "INextionTouchable.h"
 #include "Nextion.h"
+#include "NextionValueSubscription.h"
 
 /*!
  * \class NextionSlider
  * \brief Represents a slider widget.
+ *
+ * In tracking mode the value is pushed by the display while the slider is
+ * dragged, see NextionSlider::setTracking.
  */
 class NextionSlider : public INextionTouchable,
                       public INextionColourable,
-                      public INextionNumericalValued
+                      public INextionNumericalValued,
+                      public INextionPollListener
 {
 public:
+    // NEXTION_INPLACE_CALLBACK has to be set for the whole build, see
+    // INextionTouchable.h
+#ifdef NEXTION_INPLACE_CALLBACK
+    /*!
+   * \typedef TrackingCallback
+   * \brief Handler for values received while tracking, final is true for the
+   *        value on release.
+   */
+    typedef NextionInplaceFunction<void(NextionSlider *, uint32_t, bool), NEXTION_INPLACE_CALLBACK_SIZE> TrackingCallback;
+#else
+    /*!
+   * \typedef TrackingCallback
+   * \brief Handler for values received while tracking, final is true for the
+   *        value on release.
+   */
+    typedef std::function<void(NextionSlider *, uint32_t, bool)> TrackingCallback;
+#endif
+
     NextionSlider(Nextion &nex, uint8_t page, uint8_t component,
                   const String &name);
+    virtual ~NextionSlider();
 
     bool getMinValue(uint32_t &value);
     bool setMinValue(uint32_t value);
     bool getMaxValue(uint32_t &value);
     bool setMaxValue(uint32_t value);
+
+    bool setTracking(const TrackingCallback &callback, uint32_t minInterval = 50);
+    void disableTracking();
+    bool isTracking() const;
+    String getTrackingEventCode(bool release) const;
+
+    void polled();
+
+private:
+    void trackValue(uint32_t value, bool final);
+    void deliverValue(uint32_t value, bool final);
+
+    std::unique_ptr<NextionValueSubscription> m_tracking; //!< Subscription while tracking
+    TrackingCallback m_trackingCallback;                  //!< Receives tracked values
+    uint32_t m_trackingInterval;                          //!< Minimum time between deliveries in ms
+    uint32_t m_lastDelivery;                              //!< Time of the last delivery
+    uint32_t m_lastDelivered;                             //!< Last value delivered
+    bool m_delivered;                                     //!< If a value was delivered during the current drag
+    uint32_t m_pendingValue;                              //!< Latest value held back by the interval
+    bool m_pending;                                       //!< If m_pendingValue is still to be delivered
 };
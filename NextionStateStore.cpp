@@ -0,0 +1,144 @@
+/*! \file */
+
+#include "NextionStateStore.h"
+#include "NextionLogger.h"
+
+/*!
+ * \brief Creates an empty store, retention is disabled.
+ */
+NextionStateStore::NextionStateStore()
+    : m_enabled(false)
+{
+}
+
+/*!
+ * \brief Sets whether widgets retain their writes.
+ * \param enabled If writes should be retained
+ */
+void NextionStateStore::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+/*!
+ * \brief Checks if widgets retain their writes.
+ * \return True if enabled
+ */
+bool NextionStateStore::isEnabled() const
+{
+    return m_enabled;
+}
+
+/*!
+ * \brief Retains the command last written to a property, replacing the
+ *        previous one.
+ * \param pageID Page the property is on
+ * \param key Property written, e.g. "n0.val"
+ * \param command Command setting the property
+ * \param priority Priority class of the replay
+ * \return True if retained, false if the store is full
+ */
+bool NextionStateStore::retain(uint8_t pageID, const String &key, const String &command,
+                               NextionPriority priority)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+        if (iter->pageID == pageID && iter->key == key)
+        {
+            iter->command = command;
+            iter->priority = priority;
+            return true;
+        }
+    }
+
+    if (m_entries.size() >= NEXTION_STATE_STORE_LENGTH)
+    {
+        NextionLog("NextionStateStore::retain: Store full, %s not retained\n", key.c_str());
+        return false;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.command = command;
+    entry.pageID = pageID;
+    entry.priority = priority;
+    m_entries.push_back(entry);
+    return true;
+}
+
+/*!
+ * \brief Removes a retained property.
+ * \param pageID Page the property is on
+ * \param key Property, e.g. "n0.val"
+ */
+void NextionStateStore::forget(uint8_t pageID, const String &key)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+        if (iter->pageID == pageID && iter->key == key)
+        {
+            m_entries.erase(iter);
+            return;
+        }
+    }
+}
+
+/*!
+ * \brief Removes all retained properties of a page.
+ * \param pageID Page ID
+ */
+void NextionStateStore::forgetPage(uint8_t pageID)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end();)
+    {
+        if (iter->pageID == pageID)
+        {
+            iter = m_entries.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+/*!
+ * \brief Removes all retained properties.
+ */
+void NextionStateStore::clear()
+{
+    m_entries.clear();
+}
+
+/*!
+ * \brief Passes the retained commands of a page to a send function, in order
+ *        of priority class and then in the order they were first retained.
+ * \param pageID Page ID
+ * \param send Function transmitting a command
+ * \return Number of commands replayed
+ */
+size_t NextionStateStore::replay(uint8_t pageID, const SendFunction &send) const
+{
+    size_t count = 0;
+    for (uint8_t priority = 0; priority < NEX_PRIO_COUNT; ++priority)
+    {
+        for (auto iter = m_entries.cbegin(); iter != m_entries.cend(); ++iter)
+        {
+            if (iter->pageID == pageID && iter->priority == priority)
+            {
+                send(iter->command);
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+/*!
+ * \brief Gets the number of retained properties.
+ * \return Number of properties
+ */
+size_t NextionStateStore::getCount() const
+{
+    return m_entries.size();
+}
@@ -0,0 +1,68 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include <WString.h>
+#include <functional>
+#include <vector>
+
+#include "NextionTypes.h"
+
+#ifndef NEXTION_STATE_STORE_LENGTH
+#define NEXTION_STATE_STORE_LENGTH 64 //!< Number of properties retained
+#endif
+
+/*!
+ * \class NextionStateStore
+ * \brief Retains the last command written to each widget property, so the
+ *        state set by the host can be replayed after the device restarted.
+ *
+ * Entries are kept per page and replayed in order of their priority class,
+ * NEX_PRIO_ALARM first. Widgets retain their writes once retention is enabled
+ * with setEnabled().
+ */
+class NextionStateStore
+{
+public:
+    /*!
+     * \typedef SendFunction
+     * \brief Function used to transmit a replayed command.
+     */
+    typedef std::function<void(const String &command)> SendFunction;
+
+    NextionStateStore();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    bool retain(uint8_t pageID, const String &key, const String &command,
+                NextionPriority priority = NEX_PRIO_TELEMETRY);
+    void forget(uint8_t pageID, const String &key);
+    void forgetPage(uint8_t pageID);
+    void clear();
+
+    size_t replay(uint8_t pageID, const SendFunction &send) const;
+    size_t getCount() const;
+
+private:
+    /*!
+     * \struct Entry
+     * \brief The last command written to a property.
+     */
+    struct Entry
+    {
+        String key;               //!< Property written, e.g. "n0.val"
+        String command;           //!< Command text, without termination bytes
+        uint8_t pageID;           //!< Page the property is on
+        NextionPriority priority; //!< Priority class of the replay
+    };
+
+    std::vector<Entry> m_entries; //!< Retained properties
+    bool m_enabled;               //!< Whether writes are retained
+};
@@ -0,0 +1,79 @@
+/*! \file */
+
+#pragma once
+
+#include "INextionColourable.h"
+#include "INextionFontStyleable.h"
+#include "NextionCommandBatch.h"
+#include "NextionTypes.h"
+
+/*!
+ * \class NextionStyle
+ * \brief A set of appearance properties applied to a widget in one operation.
+ *
+ * Properties left at their NONE value (NEX_COL_NONE, NEX_FA_NONE, -1 for the
+ * font) are not changed.
+ */
+class NextionStyle
+{
+public:
+    /*!
+     * \brief Creates a style that changes nothing.
+     */
+    NextionStyle()
+        : foregroundColour(NEX_COL_NONE)
+        , eventForegroundColour(NEX_COL_NONE)
+        , backgroundColour(NEX_COL_NONE)
+        , eventBackgroundColour(NEX_COL_NONE)
+        , font(-1)
+        , hAlignment(NEX_FA_NONE)
+        , vAlignment(NEX_FA_NONE)
+    {
+    }
+
+    /*!
+     * \brief Applies the style to a widget.
+     * \param widget Widget implementing INextionColourable and/or
+     *               INextionFontStyleable
+     * \param refresh If the widget should be refreshed
+     * \return True if successful
+     *
+     * All property assignments are sent in a single write and their results
+     * awaited together, followed by at most one refresh.
+     */
+    template <typename Widget>
+    bool applyTo(Widget &widget, bool refresh = true) const
+    {
+        NextionCommandBatch batch;
+        append(batch, &widget);
+        appendFont(batch, &widget);
+        return static_cast<INextionWidget &>(widget).applyBatch(batch, refresh);
+    }
+
+    uint32_t foregroundColour;              //!< Normal foreground colour (pco)
+    uint32_t eventForegroundColour;         //!< Foreground colour when touched (pco2)
+    uint32_t backgroundColour;              //!< Normal background colour (bco)
+    uint32_t eventBackgroundColour;         //!< Background colour when touched (bco2)
+    int16_t font;                           //!< Font ID
+    NextionFontAlignment hAlignment;        //!< Horizontal text alignment
+    NextionFontAlignment vAlignment;        //!< Vertical text alignment
+
+private:
+    void append(NextionCommandBatch &batch, INextionColourable *widget) const
+    {
+        widget->appendColours(batch, *this);
+    }
+
+    void append(NextionCommandBatch &, const void *) const
+    {
+    }
+
+    void appendFont(NextionCommandBatch &batch, INextionFontStyleable *widget) const
+    {
+        widget->appendFontStyle(batch, *this);
+    }
+
+    void appendFont(NextionCommandBatch &, const void *) const
+    {
+    }
+};
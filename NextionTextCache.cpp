@@ -0,0 +1,243 @@
+/*! \file */
+
+#include "NextionTextCache.h"
+#include "NextionCommandBatch.h"
+#include "NextionLogger.h"
+
+/*!
+ * \brief Creates a new, empty text cache.
+ * \param nex Driver to draw with
+ */
+NextionTextCache::NextionTextCache(Nextion &nex)
+    : m_nextion(nex)
+{
+}
+
+/*!
+ * \brief Marks a font as fixed width, allowing partial redraws.
+ * \param fontID ID of the font
+ * \param charWidth Width of each character in pixels, 0 to treat the font as
+ *                  proportional again
+ */
+void NextionTextCache::setFixedWidth(uint8_t fontID, uint8_t charWidth)
+{
+    for (auto iter = m_fixedWidthFonts.begin(); iter != m_fixedWidthFonts.end(); ++iter)
+    {
+        if (iter->first == fontID)
+        {
+            if (charWidth == 0)
+            {
+                m_fixedWidthFonts.erase(iter);
+            }
+            else
+            {
+                iter->second = charWidth;
+            }
+            return;
+        }
+    }
+
+    if (charWidth != 0)
+    {
+        m_fixedWidthFonts.push_back(std::make_pair(fontID, charWidth));
+    }
+}
+
+/*!
+ * \brief Draws a string, sending only what changed since the last string drawn
+ *        in the same slot.
+ * \see Nextion::drawStr
+ * \return True if successful
+ */
+bool NextionTextCache::drawStr(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t fontID, const String &str,
+                               uint32_t bgColour, uint32_t fgColour, uint8_t bgType,
+                               NextionFontAlignment xCentre, NextionFontAlignment yCentre)
+{
+    NextionPrimitive next = NextionPrimitive();
+    next.type = NEX_PRIM_STRING;
+    next.x = x;
+    next.y = y;
+    next.w = w;
+    next.h = h;
+    next.id = fontID;
+    next.text = str;
+    next.bgColour = bgColour;
+    next.colour = fgColour;
+    next.bgType = bgType;
+    next.xCentre = xCentre;
+    next.yCentre = yCentre;
+
+    NextionPrimitive *slot = nullptr;
+    for (auto iter = m_slots.begin(); iter != m_slots.end(); ++iter)
+    {
+        if (iter->x == x && iter->y == y && iter->w == w && iter->h == h && iter->id == fontID)
+        {
+            slot = &(*iter);
+            break;
+        }
+    }
+
+    if (slot && *slot == next)
+    {
+        return true;
+    }
+
+    bool result;
+    if (slot && drawChanges(*slot, next))
+    {
+        result = true;
+    }
+    else
+    {
+        result = m_nextion.drawStr(x, y, w, h, fontID, str, bgColour, fgColour, bgType, xCentre, yCentre);
+    }
+
+    if (result)
+    {
+        if (slot)
+        {
+            *slot = next;
+        }
+        else
+        {
+            m_slots.push_back(next);
+        }
+    }
+    else if (slot)
+    {
+        // Contents of the slot are unknown now
+        slot->text = String();
+        slot->bgType = NEX_BG_NONE;
+    }
+
+    return result;
+}
+
+/*!
+ * \brief Forgets all slots, the next string drawn in each is sent in full.
+ */
+void NextionTextCache::invalidate()
+{
+    m_slots.clear();
+}
+
+/*!
+ * \brief Gets the number of slots remembered.
+ * \return Number of slots
+ */
+size_t NextionTextCache::getSlotCount() const
+{
+    return m_slots.size();
+}
+
+/*!
+ * \brief Gets the character width of a fixed width font.
+ * \param fontID ID of the font
+ * \return Width in pixels, 0 for proportional fonts
+ */
+uint8_t NextionTextCache::getCharWidth(uint8_t fontID) const
+{
+    for (auto iter = m_fixedWidthFonts.cbegin(); iter != m_fixedWidthFonts.cend(); ++iter)
+    {
+        if (iter->first == fontID)
+        {
+            return iter->second;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * \brief Draws only the changed characters of a slot.
+ * \param previous Contents of the slot on the screen
+ * \param next New contents of the slot
+ * \return True if the changes were drawn, false if they could not be drawn
+ *         partially (or failed) and the whole string must be drawn instead
+ */
+bool NextionTextCache::drawChanges(const NextionPrimitive &previous, const NextionPrimitive &next)
+{
+    uint8_t charWidth = getCharWidth(next.id);
+    if (charWidth == 0 || previous.colour != next.colour || previous.bgColour != next.bgColour ||
+        previous.bgType != next.bgType || previous.xCentre != next.xCentre || previous.yCentre != next.yCentre)
+    {
+        return false;
+    }
+    if (next.bgType != NEX_BG_SOLIDCOLOUR && next.bgType != NEX_BG_CROPIMAGE)
+    {
+        // Other backgrounds can not erase single characters
+        return false;
+    }
+
+    unsigned int oldLength = previous.text.length();
+    unsigned int newLength = next.text.length();
+    unsigned int length = oldLength > newLength ? oldLength : newLength;
+    if (static_cast<uint32_t>(length) * charWidth > next.w)
+    {
+        // Text wraps or is clipped, positions of characters are unknown
+        return false;
+    }
+
+    uint16_t start;
+    if (next.xCentre == NEX_FA_LEFT_UP)
+    {
+        start = next.x;
+    }
+    else if (next.xCentre == NEX_FA_RIGHT_DOWN && oldLength == newLength)
+    {
+        start = next.x + next.w - length * charWidth;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Shorter strings are padded with spaces to erase the old characters
+    String text(next.text);
+    while (text.length() < length)
+    {
+        text += ' ';
+    }
+
+    NextionCommandBatch batch;
+    size_t changed = 0;
+    unsigned int i = 0;
+    while (i < length)
+    {
+        if (i < oldLength && previous.text[i] == text[i])
+        {
+            i++;
+            continue;
+        }
+
+        // Extend the run over short gaps of unchanged characters
+        unsigned int end = i + 1;
+        unsigned int lastChanged = i;
+        while (end < length && end - lastChanged <= NEXTION_TEXT_CACHE_MERGE_GAP)
+        {
+            if (end >= oldLength || previous.text[end] != text[end])
+            {
+                lastChanged = end;
+            }
+            end++;
+        }
+        end = lastChanged + 1;
+
+        NextionPrimitive run(next);
+        run.x = start + i * charWidth;
+        run.w = (end - i) * charWidth;
+        run.xCentre = NEX_FA_LEFT_UP;
+        run.text = text.substring(i, end);
+        NextionDisplayList::appendCommand(batch, run);
+        changed += end - i;
+        i = end;
+    }
+
+    if (changed == length)
+    {
+        // Everything changed, not worth splitting
+        return false;
+    }
+
+    NextionLog("NextionTextCache::drawChanges: Drawing %u of %u characters\n", changed, length);
+    return m_nextion.sendBatch(batch);
+}
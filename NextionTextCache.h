@@ -0,0 +1,51 @@
+/*! \file */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "Nextion.h"
+#include "NextionDisplayList.h"
+
+#ifndef NEXTION_TEXT_CACHE_MERGE_GAP
+#define NEXTION_TEXT_CACHE_MERGE_GAP 4 //!< Unchanged characters redrawn to join two changed runs
+#endif
+
+/*!
+ * \class NextionTextCache
+ * \brief Remembers the last string drawn in each text slot and only sends
+ *        what changed.
+ *
+ * A slot is identified by its position, size and font. Drawing the same string
+ * into a slot again sends nothing. For fonts registered with setFixedWidth()
+ * only the changed characters are drawn, provided the string is left aligned
+ * (or right aligned and of unchanged length), fits the slot and has a solid
+ * colour or cropped image background.
+ *
+ * The cache assumes nothing else draws over its slots; call invalidate() when
+ * something did (e.g. after a page change).
+ */
+class NextionTextCache
+{
+public:
+    NextionTextCache(Nextion &nex);
+
+    void setFixedWidth(uint8_t fontID, uint8_t charWidth);
+
+    bool drawStr(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t fontID, const String &str,
+                 uint32_t bgColour = NEX_COL_BLACK, uint32_t fgColour = NEX_COL_WHITE,
+                 uint8_t bgType = NEX_BG_SOLIDCOLOUR, NextionFontAlignment xCentre = NEX_FA_LEFT_UP,
+                 NextionFontAlignment yCentre = NEX_FA_LEFT_UP);
+
+    void invalidate();
+    size_t getSlotCount() const;
+
+private:
+    uint8_t getCharWidth(uint8_t fontID) const;
+    bool drawChanges(const NextionPrimitive &previous, const NextionPrimitive &next);
+
+    Nextion &m_nextion;                    //!< Driver to draw with
+    std::vector<NextionPrimitive> m_slots; //!< Last string drawn per slot
+    std::vector<std::pair<uint8_t, uint8_t>> m_fixedWidthFonts; //!< Font ID and character width
+};
@@ -0,0 +1,70 @@
+/*! \file */
+
+#include "NextionTheme.h"
+
+/*!
+ * \brief Creates a theme with black text on white.
+ */
+NextionTheme::NextionTheme()
+{
+    m_colours[NEX_ROLE_BACKGROUND] = NEX_COL_WHITE;
+    m_colours[NEX_ROLE_SURFACE] = NEX_COL_WHITE;
+    m_colours[NEX_ROLE_FOREGROUND] = NEX_COL_BLACK;
+    m_colours[NEX_ROLE_ACCENT] = NEX_COL_BLUE;
+    m_colours[NEX_ROLE_DISABLED] = NEX_COL_GRAY;
+    m_colours[NEX_ROLE_WARNING] = NEX_COL_YELLOW;
+    m_colours[NEX_ROLE_ALARM] = NEX_COL_RED;
+}
+
+/*!
+ * \brief Sets the colour of a role.
+ * \param role Role
+ * \param colour RGB565 colour
+ */
+void NextionTheme::setColour(NextionThemeRole role, uint32_t colour)
+{
+    if (role < NEX_ROLE_COUNT)
+    {
+        m_colours[role] = colour;
+    }
+}
+
+/*!
+ * \brief Gets the colour of a role.
+ * \param role Role
+ * \return RGB565 colour
+ */
+uint32_t NextionTheme::getColour(NextionThemeRole role) const
+{
+    if (role < NEX_ROLE_COUNT)
+    {
+        return m_colours[role];
+    }
+    return NEX_COL_BLACK;
+}
+
+/*!
+ * \brief Creates a light theme for daytime use.
+ * \return Theme
+ */
+NextionTheme NextionTheme::day()
+{
+    return NextionTheme();
+}
+
+/*!
+ * \brief Creates a dark theme for night time use.
+ * \return Theme
+ */
+NextionTheme NextionTheme::night()
+{
+    NextionTheme theme;
+    theme.setColour(NEX_ROLE_BACKGROUND, NEX_COL_BLACK);
+    theme.setColour(NEX_ROLE_SURFACE, 0x2104);
+    theme.setColour(NEX_ROLE_FOREGROUND, 0xA000);
+    theme.setColour(NEX_ROLE_ACCENT, 0x7800);
+    theme.setColour(NEX_ROLE_DISABLED, 0x4208);
+    theme.setColour(NEX_ROLE_WARNING, 0xC400);
+    theme.setColour(NEX_ROLE_ALARM, NEX_COL_RED);
+    return theme;
+}
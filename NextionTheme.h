@@ -0,0 +1,46 @@
+/*! \file */
+
+#pragma once
+
+#if defined(SPARK) || defined(PLATFORM_ID)
+#include "application.h"
+#else
+#include <Arduino.h>
+#endif
+
+#include "NextionTypes.h"
+
+/*!
+ * \enum NextionThemeRole
+ * \brief Semantic roles a theme assigns colours to.
+ */
+enum NextionThemeRole
+{
+    NEX_ROLE_BACKGROUND = 0,   //!< Page and panel background
+    NEX_ROLE_SURFACE,          //!< Background of widgets
+    NEX_ROLE_FOREGROUND,       //!< Text and indicators
+    NEX_ROLE_ACCENT,           //!< Highlighted and pressed elements
+    NEX_ROLE_DISABLED,         //!< Inactive elements
+    NEX_ROLE_WARNING,          //!< Warnings
+    NEX_ROLE_ALARM,            //!< Alarms
+    NEX_ROLE_COUNT             //!< Number of roles
+};
+
+/*!
+ * \class NextionTheme
+ * \brief Palette mapping each NextionThemeRole to an RGB565 colour.
+ */
+class NextionTheme
+{
+public:
+    NextionTheme();
+
+    void setColour(NextionThemeRole role, uint32_t colour);
+    uint32_t getColour(NextionThemeRole role) const;
+
+    static NextionTheme day();
+    static NextionTheme night();
+
+private:
+    uint32_t m_colours[NEX_ROLE_COUNT]; //!< Colour of each role
+};
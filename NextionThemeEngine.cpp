@@ -0,0 +1,168 @@
+/*! \file */
+
+#include "NextionThemeEngine.h"
+#include "NextionLogger.h"
+#include <algorithm>
+
+/*!
+ * \brief Creates a theme engine using the default theme.
+ * \param nex Driver of the device
+ */
+NextionThemeEngine::NextionThemeEngine(Nextion &nex)
+    : m_nextion(nex)
+    , m_batch(256)
+{
+    m_nextion.registerPageListener(this);
+}
+
+/*!
+ * \brief dtor
+ */
+NextionThemeEngine::~NextionThemeEngine()
+{
+    m_nextion.unregisterPageListener(this);
+}
+
+/*!
+ * \brief Binds a colour property of a widget to a theme role.
+ * \param widget Widget, must outlive the binding
+ * \param property Colour property name (e.g. "pco", "bco2", "gdc")
+ * \param role Role providing the colour
+ */
+void NextionThemeEngine::bind(INextionColourable &widget, const String &property, NextionThemeRole role)
+{
+    for (auto iter = m_bindings.begin(); iter != m_bindings.end(); ++iter)
+    {
+        if (iter->widget == &widget && iter->property == property)
+        {
+            iter->role = role;
+            iter->applied = NEX_COL_NONE;
+            return;
+        }
+    }
+
+    Binding binding;
+    binding.widget = &widget;
+    binding.property = property;
+    binding.role = role;
+    binding.applied = NEX_COL_NONE;
+    m_bindings.push_back(binding);
+}
+
+/*!
+ * \brief Removes all bindings of a widget.
+ * \param widget Widget
+ */
+void NextionThemeEngine::unbind(INextionColourable &widget)
+{
+    for (auto iter = m_bindings.begin(); iter != m_bindings.end();)
+    {
+        if (iter->widget == &widget)
+        {
+            iter = m_bindings.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+/*!
+ * \brief Sets the theme and applies it to the displayed page.
+ * \param theme Theme
+ * \return True if successful
+ */
+bool NextionThemeEngine::setTheme(const NextionTheme &theme)
+{
+    m_theme = theme;
+    return apply();
+}
+
+/*!
+ * \brief Gets the theme being applied.
+ * \return Theme
+ */
+const NextionTheme &NextionThemeEngine::getTheme() const
+{
+    return m_theme;
+}
+
+/*!
+ * \brief Writes the colours of the theme to the bound properties on the
+ *        displayed page that do not have them yet.
+ * \return True if successful
+ *
+ * All assignments are sent in a single batch. If several widgets changed the
+ * page is then refreshed once, unless refreshes are deferred (see
+ * Nextion::setDeferredRefresh).
+ */
+bool NextionThemeEngine::apply()
+{
+    uint8_t pageID = m_nextion.getCurrentPageID();
+    const uint32_t none = NEX_COL_NONE;
+
+    m_batch.clear();
+    std::vector<INextionColourable *> changed;
+    for (auto iter = m_bindings.begin(); iter != m_bindings.end(); ++iter)
+    {
+        if (iter->widget->getPageID() != pageID)
+        {
+            continue;
+        }
+
+        uint32_t colour = m_theme.getColour(iter->role);
+        if (colour == iter->applied)
+        {
+            continue;
+        }
+
+        m_batch.addf("%s.%s=%u", iter->widget->getName().c_str(), iter->property.c_str(), colour);
+        if (std::find(changed.cbegin(), changed.cend(), iter->widget) == changed.cend())
+        {
+            changed.push_back(iter->widget);
+        }
+    }
+
+    if (changed.empty())
+    {
+        return true;
+    }
+
+    NextionLog("NextionThemeEngine::apply: Restyling %u widgets on page %u\n", changed.size(), pageID);
+    bool result = m_nextion.sendBatch(m_batch);
+    for (auto iter = m_bindings.begin(); iter != m_bindings.end(); ++iter)
+    {
+        if (iter->widget->getPageID() == pageID)
+        {
+            // On failure it is unknown which assignments were applied
+            iter->applied = result ? m_theme.getColour(iter->role) : none;
+        }
+    }
+
+    if (changed.size() > 1 && !m_nextion.isRefreshDeferred())
+    {
+        return m_nextion.refresh() && result;
+    }
+    for (auto iter = changed.cbegin(); iter != changed.cend(); ++iter)
+    {
+        result &= m_nextion.requestRefresh((*iter)->getName());
+    }
+    return result;
+}
+
+/*!
+ * \brief Applies the theme to the newly displayed page.
+ * \param pageID ID of the page now displayed
+ */
+void NextionThemeEngine::pageChanged(uint8_t pageID)
+{
+    for (auto iter = m_bindings.begin(); iter != m_bindings.end(); ++iter)
+    {
+        if (iter->widget->getPageID() == pageID)
+        {
+            iter->applied = NEX_COL_NONE;
+        }
+    }
+    apply();
+}
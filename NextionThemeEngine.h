@@ -0,0 +1,56 @@
+/*! \file */
+
+#pragma once
+
+#include <vector>
+
+#include "INextionColourable.h"
+#include "INextionPageListener.h"
+#include "Nextion.h"
+#include "NextionTheme.h"
+
+/*!
+ * \class NextionThemeEngine
+ * \brief Applies a NextionTheme to bound colour properties of widgets.
+ *
+ * Properties of the widgets on the displayed page are restyled in a single
+ * batch. Only properties whose colour differs from the one last written are
+ * sent. The theme is applied again whenever the displayed page changes, since
+ * the device resets widgets to their defaults when it loads a page.
+ *
+ * Page changes made on the display itself are only seen if the page reports
+ * itself, i.e. runs sendme in its preinit event.
+ */
+class NextionThemeEngine : public INextionPageListener
+{
+public:
+    NextionThemeEngine(Nextion &nex);
+    virtual ~NextionThemeEngine();
+
+    void bind(INextionColourable &widget, const String &property, NextionThemeRole role);
+    void unbind(INextionColourable &widget);
+
+    bool setTheme(const NextionTheme &theme);
+    const NextionTheme &getTheme() const;
+    bool apply();
+
+    void pageChanged(uint8_t pageID);
+
+private:
+    /*!
+     * \struct Binding
+     * \brief A colour property bound to a theme role.
+     */
+    struct Binding
+    {
+        INextionColourable *widget; //!< Widget owning the property
+        String property;            //!< Property name (e.g. "bco")
+        NextionThemeRole role;      //!< Role providing the colour
+        uint32_t applied;           //!< Colour last written, NEX_COL_NONE if unknown
+    };
+
+    Nextion &m_nextion;             //!< Driver of the device
+    NextionTheme m_theme;           //!< Theme being applied
+    std::vector<Binding> m_bindings;
+    NextionCommandBatch m_batch;    //!< Reused for each application
+};
@@ -1,5 +1,6 @@
 /*! \file */
 
+#include <math.h>
 #include "NextionTimer.h"
 
 /*!
@@ -9,6 +10,14 @@ NextionTimer::NextionTimer(Nextion &nex, uint8_t page, uint8_t component,
                            const String &name)
     : INextionWidget(nex, page, component, name)
     , INextionTouchable(nex, page, component, name)
+    , m_nominalCycle(0)
+    , m_lastTick(0)
+    , m_lastTickMillis(0)
+    , m_tickCount(0)
+    , m_missedTicks(0)
+    , m_intervalCount(0)
+    , m_meanInterval(0.0)
+    , m_intervalM2(0.0)
 {
 }
 
@@ -31,7 +40,10 @@ bool NextionTimer::setCycle(uint32_t cycle)
 {
     if (cycle < 50)
         return false;
-    return setNumberProperty("tim", cycle);
+    if (!setNumberProperty("tim", cycle))
+        return false;
+    setNominalCycle(cycle);
+    return true;
 }
 
 /*!
@@ -51,3 +63,176 @@ bool NextionTimer::disable()
 {
     return setNumberProperty("en", 0);
 }
+
+/*!
+ * \brief Starts the timer as a heartbeat.
+ * \param cycle Time between ticks in ms
+ * \return True if successful
+ *
+ * The Timer Event of the timer must contain the code returned by
+ * getTickEventCode().
+ */
+bool NextionTimer::startHeartbeat(uint32_t cycle)
+{
+    resetStatistics();
+    m_lastTickMillis = millis();
+    return setCycle(cycle) && enable();
+}
+
+/*!
+ * \brief Checks if the display is alive, i.e. ticks keep arriving.
+ * \param missedTicks Number of consecutive ticks that may be missing
+ * \return True if the last tick arrived less than missedTicks + 1 cycles ago
+ */
+bool NextionTimer::isAlive(uint8_t missedTicks) const
+{
+    if (m_nominalCycle == 0)
+    {
+        return false;
+    }
+    return getTimeSinceLastTick() <= m_nominalCycle * (missedTicks + 1);
+}
+
+/*!
+ * \brief Gets the time since the last tick arrived.
+ * \return Time in ms, since startHeartbeat() if no tick arrived yet
+ */
+uint32_t NextionTimer::getTimeSinceLastTick() const
+{
+    return millis() - m_lastTickMillis;
+}
+
+/*!
+ * \brief Gets the code to add to the Timer Event of the timer in the Nextion
+ *        Editor to report each tick.
+ * \return Event code
+ */
+String NextionTimer::getTickEventCode()
+{
+    char code[40];
+    snprintf(code, sizeof(code), "printh %02X %02X %02X %02X FF FF FF\r\n", NEX_RET_EVENT_TOUCH_HEAD,
+             m_pageID, m_componentID, NEX_EVENT_PUSH);
+    return String(code);
+}
+
+/*!
+ * \brief Sets the expected time between ticks, used to detect lost ticks and
+ *        to calculate the drift. Done by setCycle().
+ * \param cycle Time in ms
+ */
+void NextionTimer::setNominalCycle(uint32_t cycle)
+{
+    m_nominalCycle = cycle;
+}
+
+/*!
+ * \brief Clears the tick statistics.
+ */
+void NextionTimer::resetStatistics()
+{
+    m_tickCount = 0;
+    m_missedTicks = 0;
+    m_intervalCount = 0;
+    m_meanInterval = 0.0;
+    m_intervalM2 = 0.0;
+}
+
+/*!
+ * \brief Gets the number of ticks received.
+ * \return Number of ticks
+ */
+uint32_t NextionTimer::getTickCount() const
+{
+    return m_tickCount;
+}
+
+/*!
+ * \brief Gets the number of ticks estimated to be lost, from intervals of
+ *        more than 1.5 cycles.
+ * \return Number of lost ticks
+ */
+uint32_t NextionTimer::getMissedTickCount() const
+{
+    return m_missedTicks;
+}
+
+/*!
+ * \brief Gets the mean time between two ticks.
+ * \return Mean interval in us, 0 before two ticks were received
+ */
+double NextionTimer::getMeanInterval() const
+{
+    return m_meanInterval;
+}
+
+/*!
+ * \brief Gets the jitter of the time between two ticks.
+ * \return Standard deviation of the interval in us
+ */
+double NextionTimer::getJitter() const
+{
+    if (m_intervalCount < 2)
+    {
+        return 0.0;
+    }
+    return sqrt(m_intervalM2 / (m_intervalCount - 1));
+}
+
+/*!
+ * \brief Gets the drift of the display timer relative to the host clock.
+ * \return Drift in ppm, positive if the display ticks slower than nominal, 0
+ *         if the nominal cycle is unknown
+ */
+double NextionTimer::getDrift() const
+{
+    if (m_nominalCycle == 0 || m_intervalCount == 0)
+    {
+        return 0.0;
+    }
+    double nominal = m_nominalCycle * 1000.0;
+    return (m_meanInterval - nominal) / nominal * 1e6;
+}
+
+/*!
+ * \copydoc INextionTouchable::processEvent
+ *
+ * Ticks are recorded in addition to calling the attached callback.
+ */
+bool NextionTimer::processEvent(uint8_t pageID, uint8_t componentID, uint8_t eventType)
+{
+    if (pageID == m_pageID && componentID == m_componentID && eventType == NEX_EVENT_PUSH)
+    {
+        recordTick(m_nextion.getEventTimestamp());
+    }
+    return INextionTouchable::processEvent(pageID, componentID, eventType);
+}
+
+/*!
+ * \brief Adds a tick to the statistics.
+ * \param timestamp Value of micros() when the tick arrived
+ */
+void NextionTimer::recordTick(uint32_t timestamp)
+{
+    if (m_tickCount > 0)
+    {
+        uint32_t interval = timestamp - m_lastTick;
+        uint32_t nominal = m_nominalCycle * 1000;
+        if (nominal > 0 && interval > nominal + nominal / 2)
+        {
+            // Ticks were lost, the interval says nothing about the jitter
+            m_missedTicks += (interval + nominal / 2) / nominal - 1;
+        }
+        else
+        {
+            // Welford's online mean and variance
+            ++m_intervalCount;
+            double delta = interval - m_meanInterval;
+            m_meanInterval += delta / m_intervalCount;
+            m_intervalM2 += delta * (interval - m_meanInterval);
+        }
+    }
+
+    ++m_tickCount;
+    m_lastTick = timestamp;
+    m_lastTickMillis = millis();
+}
@@ -8,6 +8,11 @@
 /*!
  * \class NextionTimer
  * \brief Represents a timer.
+ *
+ * If the Timer Event of the timer sends a touch event (see getTickEventCode())
+ * each tick is timestamped on arrival, which gives the drift and jitter of the
+ * display clock relative to micros() and allows the timer to be used as a
+ * heartbeat to detect a stalled display without extra round trips.
  */
 class NextionTimer : public INextionTouchable
 {
@@ -19,4 +24,31 @@ public:
 
     bool enable();
     bool disable();
+
+    bool startHeartbeat(uint32_t cycle);
+    bool isAlive(uint8_t missedTicks = 2) const;
+    uint32_t getTimeSinceLastTick() const;
+    String getTickEventCode();
+
+    void setNominalCycle(uint32_t cycle);
+    void resetStatistics();
+    uint32_t getTickCount() const;
+    uint32_t getMissedTickCount() const;
+    double getMeanInterval() const;
+    double getJitter() const;
+    double getDrift() const;
+
+    bool processEvent(uint8_t pageID, uint8_t componentID, uint8_t eventType);
+
+private:
+    void recordTick(uint32_t timestamp);
+
+    uint32_t m_nominalCycle;   //!< Expected time between ticks in ms, 0 if unknown
+    uint32_t m_lastTick;       //!< Value of micros() at the last tick
+    uint32_t m_lastTickMillis; //!< Value of millis() at the last tick
+    uint32_t m_tickCount;      //!< Number of ticks received
+    uint32_t m_missedTicks;    //!< Number of ticks estimated to be lost
+    uint32_t m_intervalCount;  //!< Number of intervals in the statistics
+    double m_meanInterval;     //!< Mean interval between ticks in us
+    double m_intervalM2;       //!< Sum of squared deviations from the mean (Welford)
 };
@@ -112,3 +112,38 @@ enum NextionScrollDirection
     NEX_SCROLL_UP = 3,
     NEX_SCROLL_DOWN = 2
 };
+
+/*!
+ * \enum NextionPriority
+ * \brief Priority classes for scheduled outgoing commands.
+ */
+enum NextionPriority
+{
+    NEX_PRIO_ALARM = 0,       //!< Alarms, always sent first and never limited
+    NEX_PRIO_INTERACTIVE = 1, //!< Feedback to user interaction
+    NEX_PRIO_TELEMETRY = 2,   //!< Periodic values that may go stale
+    NEX_PRIO_BULK = 3,        //!< Large transfers (e.g. xstr, addt)
+    NEX_PRIO_COUNT            //!< Number of priority classes
+};
+
+/*!
+ * \enum NextionLinkState
+ * \brief Health of the serial link as seen by NextionLinkMonitor.
+ */
+enum NextionLinkState
+{
+    NEX_LINK_UNKNOWN = 0, //!< No reply received yet
+    NEX_LINK_ALIVE = 1,   //!< The device replies
+    NEX_LINK_DEAD = 2     //!< Replies timed out repeatedly, reads fail fast
+};
+
+/*!
+ * \enum NextionEventKind
+ * \brief Kinds of events received from the device and dispatched to callbacks.
+ */
+enum NextionEventKind
+{
+    NEX_EVENT_KIND_TOUCH = 0,      //!< Touch event of a component
+    NEX_EVENT_KIND_VALUE = 1,      //!< Value change notification
+    NEX_EVENT_KIND_FINAL_VALUE = 2 //!< Notification of the final value, e.g. on release
+};
@@ -0,0 +1,146 @@
+/*! \file */
+
+#include "NextionValueSubscription.h"
+#include "NextionLogger.h"
+
+/*!
+ * \brief Creates a subscription and registers it with the driver of the
+ *        widget.
+ * \param widget Widget to receive values of
+ * \param propertyName Numerical property sent by the event code
+ */
+NextionValueSubscription::NextionValueSubscription(INextionWidget &widget, const String &propertyName)
+    : m_widget(widget)
+    , m_propertyName(propertyName)
+    , m_value(0)
+    , m_hasValue(false)
+    , m_final(false)
+{
+    m_widget.getNextion().registerValueSubscription(this);
+}
+
+/*!
+ * \brief dtor, unregisters the subscription.
+ */
+NextionValueSubscription::~NextionValueSubscription()
+{
+    m_widget.getNextion().unregisterValueSubscription(this);
+}
+
+/*!
+ * \brief Attaches a callback called with each reported value.
+ * \param callback Callback function
+ * \return True if successful
+ */
+bool NextionValueSubscription::attachCallback(const ValueCallback &callback)
+{
+    if (!callback)
+    {
+        return false;
+    }
+
+    m_callback = callback;
+    return true;
+}
+
+/*!
+ * \brief Removes the callback.
+ */
+void NextionValueSubscription::detachCallback()
+{
+    m_callback = nullptr;
+}
+
+/*!
+ * \brief Processes a value change notification.
+ * \param pageID Page ID of the notification
+ * \param componentID Component ID of the notification
+ * \param value Reported value
+ * \param final If the value was reported as final (NEXTION_VALUE_FINAL_HEAD)
+ * \return True if the notification is for this subscription
+ */
+bool NextionValueSubscription::processValueChange(uint8_t pageID, uint8_t componentID, uint32_t value, bool final)
+{
+    if (pageID != m_widget.getPageID() || componentID != m_widget.getComponentID())
+    {
+        return false;
+    }
+
+    m_value = value;
+    m_hasValue = true;
+    m_final = final;
+    if (m_callback)
+    {
+        m_callback(this, value);
+    }
+    return true;
+}
+
+/*!
+ * \brief Gets the event code to add to the widget in the Nextion Editor.
+ * \param final If the code reports the final value (e.g. for Touch Release)
+ * \return Event code, one instruction per line
+ */
+String NextionValueSubscription::getEventCode(bool final) const
+{
+    return makeEventCode(m_widget, m_propertyName, final);
+}
+
+/*!
+ * \brief Generates event code sending a value change notification.
+ * \param widget Widget whose value is sent
+ * \param propertyName Numerical property to send
+ * \param final If the code reports the final value (e.g. for Touch Release)
+ * \return Event code, one instruction per line
+ */
+String NextionValueSubscription::makeEventCode(INextionWidget &widget, const String &propertyName, bool final)
+{
+    char header[48];
+    snprintf(header, sizeof(header), "printh %02X %02X %02X\r\nprints ",
+             final ? NEXTION_VALUE_FINAL_HEAD : NEXTION_VALUE_CHANGE_HEAD,
+             widget.getPageID(), widget.getComponentID());
+    String code(header);
+    code += widget.getName();
+    code += ".";
+    code += propertyName;
+    code += ",4\r\nprinth FF FF FF\r\n";
+    return code;
+}
+
+/*!
+ * \brief Checks if the last value was reported as final, i.e. by event code
+ *        for the end of an interaction.
+ * \return True if final
+ */
+bool NextionValueSubscription::isFinal() const
+{
+    return m_final;
+}
+
+/*!
+ * \brief Gets the widget whose value is reported.
+ * \return Widget
+ */
+INextionWidget &NextionValueSubscription::getWidget()
+{
+    return m_widget;
+}
+
+/*!
+ * \brief Checks if a value has been reported since the subscription was
+ *        created.
+ * \return True if getValue() is valid
+ */
+bool NextionValueSubscription::hasValue() const
+{
+    return m_hasValue;
+}
+
+/*!
+ * \brief Gets the last reported value.
+ * \return Value
+ */
+uint32_t NextionValueSubscription::getValue() const
+{
+    return m_value;
+}
@@ -0,0 +1,67 @@
+/*! \file */
+
+#pragma once
+
+#include <functional>
+#include "INextionTouchable.h"
+#include "INextionWidget.h"
+#include "Nextion.h"
+
+/*!
+ * \class NextionValueSubscription
+ * \brief Receives the value of a widget whenever the display reports a change.
+ *
+ * The library can not install code on the display, so the event code returned
+ * by getEventCode() has to be added to the widget in the Nextion Editor (e.g.
+ * to the Touch Release event of a checkbox or the Touch Move event of a
+ * slider). It sends a notification frame of NEXTION_VALUE_CHANGE_HEAD, page ID,
+ * component ID and the value as 4 bytes (little endian), which Nextion::poll()
+ * dispatches to the subscription, so the value no longer has to be polled.
+ * Like touch events, notifications are queued while events are deferred (see
+ * Nextion::setDeferredEvents()).
+ *
+ * Event code for the end of an interaction (e.g. Touch Release) may send
+ * NEXTION_VALUE_FINAL_HEAD instead, see isFinal().
+ */
+class NextionValueSubscription
+{
+public:
+    // NEXTION_INPLACE_CALLBACK has to be set for the whole build, see
+    // INextionTouchable.h
+#ifdef NEXTION_INPLACE_CALLBACK
+    /*!
+     * \typedef ValueCallback
+     * \brief Handler function for value changes.
+     */
+    typedef NextionInplaceFunction<void(NextionValueSubscription *, uint32_t), NEXTION_INPLACE_CALLBACK_SIZE> ValueCallback;
+#else
+    /*!
+     * \typedef ValueCallback
+     * \brief Handler function for value changes.
+     */
+    typedef std::function<void(NextionValueSubscription *, uint32_t)> ValueCallback;
+#endif
+
+    NextionValueSubscription(INextionWidget &widget, const String &propertyName = "val");
+    ~NextionValueSubscription();
+
+    bool attachCallback(const ValueCallback &callback);
+    void detachCallback();
+
+    bool processValueChange(uint8_t pageID, uint8_t componentID, uint32_t value, bool final = false);
+
+    String getEventCode(bool final = false) const;
+    static String makeEventCode(INextionWidget &widget, const String &propertyName, bool final);
+    INextionWidget &getWidget();
+    bool hasValue() const;
+    uint32_t getValue() const;
+    bool isFinal() const;
+
+private:
+    INextionWidget &m_widget; //!< Widget whose value is reported
+    String m_propertyName;    //!< Property reported by the event code
+    ValueCallback m_callback; //!< Called for each reported value
+    uint32_t m_value;         //!< Last value reported
+    bool m_hasValue;          //!< If a value was reported yet
+    bool m_final;             //!< If the last value was reported as final
+};
@@ -0,0 +1,385 @@
+#include <Nextion.h>
+#include <NextionButton.h>
+#include <NextionWaveform.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Micro-benchmarks of the library code paths, run against an emulated display
+ * so the results do not depend on the baud rate or a device being attached.
+ *
+ * Each benchmark reports the time and the bytes written to the display per
+ * operation. Results are printed as a single JSON document to Serial, so they
+ * can be collected and compared across library versions.
+ *
+ * The same benchmarks are built for a PC by "make bench" in extra/host, which
+ * compares the results with a baseline. This sketch runs them on the device.
+ * Like the library it needs an ESP32 (Serial.printf(), getCpuFrequencyMhz()).
+ *
+ * Allocations per operation are only reported on the host, where String
+ * buffers come from operator new as well. On the device they come from
+ * malloc(), which a sketch cannot count, so most of the heap churn would be
+ * missed.
+ */
+
+#if !defined(ESP32) && !defined(NEXTION_HOST)
+#error "The benchmark needs an ESP32, or the host harness in extra/host"
+#endif
+
+#ifndef BENCHMARK_ITERATIONS
+#define BENCHMARK_ITERATIONS 1000 // Operations per benchmark
+#endif
+#define BENCHMARK_WARMUP 10       // Operations run before timing starts
+#define BENCHMARK_TOUCHABLES 16   // Buttons registered for touch dispatch
+#define BENCHMARK_FIRMWARE_SIZE 16384
+
+#ifdef NEXTION_HOST
+static uint32_t allocations = 0;
+
+void *operator new(size_t size)
+{
+  ++allocations;
+  return malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size)
+{
+  ++allocations;
+  return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+  free(ptr);
+}
+#endif
+
+/*
+ * Emulates a display with bkcmd=3: every command is acknowledged, "get"
+ * commands return a number and "whmi-wri" starts a firmware upload which is
+ * acknowledged per 4096 byte chunk. Replies are kept in a fixed ring buffer so
+ * the emulation itself does not allocate.
+ */
+class EmulatedDisplay : public Stream
+{
+public:
+  EmulatedDisplay()
+      : m_head(0), m_tail(0), m_terminators(0), m_commandLength(0),
+        m_uploadRemaining(0), m_uploadChunk(0), m_ackDeferred(false),
+        m_ackArmed(false), m_written(0)
+  {
+  }
+
+  size_t write(uint8_t b)
+  {
+    ++m_written;
+
+    if (m_uploadRemaining > 0)
+    {
+      receiveFirmware();
+      return 1;
+    }
+
+    if (b == 0xFF)
+    {
+      if (++m_terminators == 3)
+      {
+        m_terminators = 0;
+        m_command[m_commandLength] = '\0';
+        execute();
+        m_commandLength = 0;
+      }
+    }
+    else
+    {
+      m_terminators = 0;
+      if (m_commandLength < sizeof(m_command) - 1)
+        m_command[m_commandLength++] = (char)b;
+    }
+    return 1;
+  }
+
+  int available()
+  {
+    size_t count = (m_tail - m_head + sizeof(m_rx)) % sizeof(m_rx);
+    if (m_ackDeferred && count == 0)
+    {
+      // The first upload acknowledgement arrives after the host flushed its
+      // input, as it would from a real display
+      if (!m_ackArmed)
+      {
+        m_ackArmed = true;
+        return 0;
+      }
+      m_ackDeferred = false;
+      push(0x05);
+      count = 1;
+    }
+    return count;
+  }
+
+  int read()
+  {
+    if (available() == 0)
+      return -1;
+    uint8_t b = m_rx[m_head];
+    m_head = (m_head + 1) % sizeof(m_rx);
+    return b;
+  }
+
+  int peek()
+  {
+    if (available() == 0)
+      return -1;
+    return m_rx[m_head];
+  }
+
+  void flush()
+  {
+  }
+
+  void inject(const uint8_t *data, size_t length)
+  {
+    for (size_t i = 0; i < length; i++)
+      push(data[i]);
+  }
+
+  uint32_t getWritten() const
+  {
+    return m_written;
+  }
+
+private:
+  uint8_t m_rx[8192];
+  size_t m_head;
+  size_t m_tail;
+  uint8_t m_terminators;
+  char m_command[64];
+  size_t m_commandLength;
+  size_t m_uploadRemaining;
+  size_t m_uploadChunk;
+  bool m_ackDeferred;
+  bool m_ackArmed;
+  uint32_t m_written;
+
+  void push(uint8_t b)
+  {
+    size_t next = (m_tail + 1) % sizeof(m_rx);
+    if (next != m_head)
+    {
+      m_rx[m_tail] = b;
+      m_tail = next;
+    }
+  }
+
+  void execute()
+  {
+    if (strncmp(m_command, "whmi-wri ", 9) == 0)
+    {
+      m_uploadRemaining = strtoul(m_command + 9, NULL, 10);
+      m_uploadChunk = 0;
+      m_ackDeferred = true;
+      m_ackArmed = false;
+    }
+    else if (strncmp(m_command, "get ", 4) == 0)
+    {
+      const uint8_t reply[] = {0x71, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF};
+      inject(reply, sizeof(reply));
+    }
+    else
+    {
+      const uint8_t reply[] = {0x01, 0xFF, 0xFF, 0xFF};
+      inject(reply, sizeof(reply));
+    }
+  }
+
+  void receiveFirmware()
+  {
+    --m_uploadRemaining;
+    if (m_uploadRemaining == 0)
+    {
+      const uint8_t reply[] = {0x05, 0x88, 0xFF, 0xFF, 0xFF};
+      inject(reply, sizeof(reply));
+    }
+    else if (++m_uploadChunk == 4096)
+    {
+      m_uploadChunk = 0;
+      push(0x05);
+    }
+  }
+};
+
+/*
+ * Firmware image read from memory, rewound before each upload.
+ */
+class FirmwareImage : public Stream
+{
+public:
+  FirmwareImage(size_t size)
+      : m_size(size), m_position(0)
+  {
+  }
+
+  void rewind()
+  {
+    m_position = 0;
+  }
+
+  int available()
+  {
+    return m_size - m_position;
+  }
+
+  int read()
+  {
+    if (m_position >= m_size)
+      return -1;
+    return (uint8_t)(m_position++);
+  }
+
+  int peek()
+  {
+    if (m_position >= m_size)
+      return -1;
+    return (uint8_t)m_position;
+  }
+
+  size_t write(uint8_t)
+  {
+    return 0;
+  }
+
+  void flush()
+  {
+  }
+
+private:
+  size_t m_size;
+  size_t m_position;
+};
+
+EmulatedDisplay display;
+FirmwareImage firmware(BENCHMARK_FIRMWARE_SIZE);
+Nextion nex(display);
+NextionWaveform waveform(nex, 0, 2, "s0");
+NextionButton *buttons[BENCHMARK_TOUCHABLES];
+
+uint32_t touches = 0;
+bool firstResult = true;
+
+void callback(NextionEventType type, INextionTouchable *widget)
+{
+  touches++;
+}
+
+void runBenchmark(const char *name, uint32_t iterations, void (*op)(uint32_t))
+{
+  for (uint32_t i = 0; i < BENCHMARK_WARMUP; i++)
+    op(i);
+
+#ifdef NEXTION_HOST
+  uint32_t startAllocations = allocations;
+#endif
+  uint32_t startWritten = display.getWritten();
+  uint32_t start = micros();
+
+  for (uint32_t i = 0; i < iterations; i++)
+    op(i);
+
+  uint32_t elapsed = micros() - start;
+  uint32_t written = display.getWritten() - startWritten;
+
+  Serial.printf("%s\n    {\"name\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f, \"bytes_per_op\": %.1f",
+                firstResult ? "" : ",", name, iterations, elapsed * 1000.0 / iterations,
+                (double)written / iterations);
+#ifdef NEXTION_HOST
+  Serial.printf(", \"allocs_per_op\": %.2f", (double)(allocations - startAllocations) / iterations);
+#endif
+  Serial.print("}");
+  firstResult = false;
+}
+
+void benchSendCommand(uint32_t i)
+{
+  nex.sendCommand("%s.val=%u", "n0", i);
+  nex.checkCommandComplete();
+}
+
+void benchReadMessage(uint32_t i)
+{
+  // Touch event for a component nothing is registered for
+  const uint8_t event[] = {0x65, 0x01, 0x7F, 0x01, 0xFF, 0xFF, 0xFF};
+  display.inject(event, sizeof(event));
+  nex.poll();
+}
+
+void benchTouchDispatch(uint32_t i)
+{
+  // Touch event for the last button registered
+  const uint8_t event[] = {0x65, 0x01, BENCHMARK_TOUCHABLES, (uint8_t)(i & 1), 0xFF, 0xFF, 0xFF};
+  display.inject(event, sizeof(event));
+  nex.poll();
+}
+
+void benchReceiveString(uint32_t i)
+{
+  const uint8_t reply[] = {0x70, 'B', 'e', 'n', 'c', 'h', 'm', 'a', 'r', 'k', ' ',
+                           'r', 'e', 's', 'u', 'l', 't', 0xFF, 0xFF, 0xFF};
+  display.inject(reply, sizeof(reply));
+  String value;
+  nex.receiveString(value);
+}
+
+// Built once, so the benchmark does not time its construction
+const String drawText("Say \"hello\" to C:\\nextion");
+
+void benchDrawStr(uint32_t i)
+{
+  nex.drawStr(0, 0, 100, 20, 0, drawText, NEX_COL_BLACK);
+}
+
+void benchWaveform(uint32_t i)
+{
+  waveform.addValue(i & 3, i & 0xFF);
+}
+
+void benchFirmwareUpload(uint32_t i)
+{
+  String md5;
+  firmware.rewind();
+  nex.uploadFirmware(firmware, BENCHMARK_FIRMWARE_SIZE, 9600, md5);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  nex.init();
+
+  for (uint8_t i = 0; i < BENCHMARK_TOUCHABLES; i++)
+  {
+    buttons[i] = new NextionButton(nex, 1, i + 1, "b");
+    buttons[i]->attachCallback(&callback);
+  }
+
+  Serial.printf("{\n  \"cpu_mhz\": %u,\n  \"benchmarks\": [", getCpuFrequencyMhz());
+
+  runBenchmark("send_command_format", BENCHMARK_ITERATIONS, &benchSendCommand);
+  runBenchmark("read_message", BENCHMARK_ITERATIONS, &benchReadMessage);
+  runBenchmark("touch_dispatch", BENCHMARK_ITERATIONS, &benchTouchDispatch);
+  runBenchmark("receive_string", BENCHMARK_ITERATIONS, &benchReceiveString);
+  runBenchmark("draw_str_escaped", BENCHMARK_ITERATIONS, &benchDrawStr);
+  runBenchmark("waveform_add_value", BENCHMARK_ITERATIONS, &benchWaveform);
+  runBenchmark("firmware_upload_16k", 10, &benchFirmwareUpload);
+
+  Serial.printf("\n  ],\n  \"touch_events\": %u\n}\n", touches);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,157 @@
+/*! \file */
+
+#pragma once
+
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+/*!
+ * \class FakeDisplay
+ * \brief Stream emulating a display connected to the host.
+ *
+ * Bytes injected are read by the driver. Commands written are recorded and,
+ * like a display with bkcmd=3, acknowledged with NEX_RET_CMD_FINISHED; get
+ * commands are answered with the number 0 instead. Replies to commands set by
+ * setReplyDelay() arrive late, and replies after them wait behind them.
+ */
+class FakeDisplay : public Stream
+{
+public:
+    FakeDisplay()
+        : m_acknowledge(true)
+        , m_terminators(0)
+        , m_replyDelay(0)
+    {
+    }
+
+    size_t write(uint8_t b)
+    {
+        if (b != 0xFF)
+        {
+            m_terminators = 0;
+            m_command += static_cast<char>(b);
+            return 1;
+        }
+
+        if (++m_terminators == 3)
+        {
+            m_terminators = 0;
+            m_commands.push_back(m_command);
+            if (m_acknowledge)
+            {
+                uint32_t delay = m_command.compare(0, m_delayedCommand.size(), m_delayedCommand) == 0 ? m_replyDelay : 0;
+                if (m_command.compare(0, 4, "get ") == 0)
+                {
+                    reply({0x71, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF}, delay);
+                }
+                else
+                {
+                    reply({0x01, 0xFF, 0xFF, 0xFF}, delay);
+                }
+            }
+            m_command.clear();
+        }
+        return 1;
+    }
+
+    int available()
+    {
+        releaseReplies();
+        return m_input.size();
+    }
+
+    int read()
+    {
+        releaseReplies();
+        if (m_input.empty())
+        {
+            return -1;
+        }
+        int b = m_input.front();
+        m_input.pop_front();
+        return b;
+    }
+
+    int peek()
+    {
+        releaseReplies();
+        return m_input.empty() ? -1 : m_input.front();
+    }
+
+    void inject(const uint8_t *data, size_t length)
+    {
+        m_input.insert(m_input.end(), data, data + length);
+    }
+
+    void inject(std::initializer_list<uint8_t> data)
+    {
+        m_input.insert(m_input.end(), data.begin(), data.end());
+    }
+
+    void setAcknowledge(bool acknowledge)
+    {
+        m_acknowledge = acknowledge;
+    }
+
+    void setReplyDelay(const std::string &command, uint32_t delay)
+    {
+        m_delayedCommand = command;
+        m_replyDelay = delay;
+    }
+
+    const std::vector<std::string> &getCommands() const
+    {
+        return m_commands;
+    }
+
+    void clearCommands()
+    {
+        m_commands.clear();
+    }
+
+private:
+    /*!
+     * \struct Reply
+     * \brief Reply waiting to be sent.
+     */
+    struct Reply
+    {
+        uint32_t time;             //!< Value of millis() the reply is sent at
+        std::vector<uint8_t> data; //!< Bytes of the reply
+    };
+
+    std::deque<uint8_t> m_input;         //!< Bytes waiting to be read by the driver
+    std::deque<Reply> m_replies;         //!< Replies not sent yet, in order
+    std::vector<std::string> m_commands; //!< Commands written, without termination bytes
+    std::string m_command;               //!< Command being written
+    bool m_acknowledge;                  //!< Whether commands are answered
+    uint8_t m_terminators;               //!< Number of consecutive 0xFF written
+    std::string m_delayedCommand;        //!< Start of the commands whose replies are late
+    uint32_t m_replyDelay;               //!< Time in ms replies to them are late
+
+    void reply(std::initializer_list<uint8_t> data, uint32_t delay)
+    {
+        Reply reply;
+        reply.time = millis() + delay;
+        reply.data.assign(data.begin(), data.end());
+        if (!m_replies.empty())
+        {
+            reply.time = std::max(reply.time, m_replies.back().time);
+        }
+        m_replies.push_back(reply);
+        releaseReplies();
+    }
+
+    void releaseReplies()
+    {
+        while (!m_replies.empty() && static_cast<int32_t>(millis() - m_replies.front().time) >= 0)
+        {
+            inject(&m_replies.front().data[0], m_replies.front().data.size());
+            m_replies.pop_front();
+        }
+    }
+};
@@ -0,0 +1,14 @@
+/*! \file */
+
+/*
+ * Runs the benchmarks of examples/Benchmark on the host. The sketch prints its
+ * results as JSON to Serial, which the shim writes to stdout.
+ */
+
+void setup();
+
+int main()
+{
+    setup();
+    return 0;
+}
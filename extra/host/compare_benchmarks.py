@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Compares two benchmark results printed by examples/Benchmark.
+
+Usage: compare_benchmarks.py BASELINE CURRENT [--threshold FRACTION]
+
+Bytes and allocations per operation are deterministic and must not grow.
+Time per operation may grow by the threshold (0.25 by default) before it
+counts as a regression. Exits with status 1 on any regression.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.25,
+                        help="allowed relative growth of ns_per_op")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+
+    print("%-24s %12s %12s %8s  %s" % ("benchmark", "base ns/op", "ns/op", "change", "notes"))
+    for name, result in current.items():
+        base = baseline.get(name)
+        if base is None:
+            print("%-24s %12s %12.1f %8s  new" % (name, "-", result["ns_per_op"], "-"))
+            continue
+
+        notes = []
+        change = result["ns_per_op"] / base["ns_per_op"] - 1 if base["ns_per_op"] else 0.0
+        if change > args.threshold:
+            notes.append("slower")
+        for key in ("bytes_per_op", "allocs_per_op"):
+            # Allocations are only reported by host builds
+            if key in result and key in base and result[key] > base[key]:
+                notes.append("%s %.2f -> %.2f" % (key, base[key], result[key]))
+        regressions += len(notes) > 0
+
+        print("%-24s %12.1f %12.1f %+7.0f%%  %s" % (name, base["ns_per_op"], result["ns_per_op"],
+                                                   change * 100, ", ".join(notes)))
+
+    for name in baseline:
+        if name not in current:
+            print("%-24s missing" % name)
+            regressions += 1
+
+    print("%d regression(s)" % regressions)
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
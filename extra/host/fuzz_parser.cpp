@@ -0,0 +1,130 @@
+/*! \file */
+
+/*
+ * Fuzz target of the receive parser. The input is split into chunks, each
+ * injected as received bytes before one driver call reads them: poll(),
+ * receiveString(), receiveNumber(), receiveNumbers(), checkCommandComplete()
+ * or getCurrentPage().
+ *
+ * Built with -DNEXTION_LIBFUZZER and -fsanitize=fuzzer this is a libFuzzer
+ * target. Otherwise main() runs the files given, or a number of random inputs,
+ * which is how "make test-asan" runs it under the sanitizers.
+ */
+
+#include <fstream>
+#include <iterator>
+#include <random>
+
+#include "FakeDisplay.h"
+#include "Nextion.h"
+#include "NextionButton.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FakeDisplay display;
+    display.setAcknowledge(false);
+    // Short timeouts, reads waiting for missing replies dominate otherwise
+    Nextion nex(display, 2);
+    NextionButton button(nex, 1, 1, "b0");
+    button.attachCallback([](NextionEventType, INextionTouchable *) {});
+
+    size_t position = 0;
+    while (position + 2 <= size)
+    {
+        uint8_t operation = data[position];
+        size_t length = std::min<size_t>(data[position + 1], size - position - 2);
+        position += 2;
+        display.inject(data + position, length);
+        position += length;
+
+        switch (operation % 8)
+        {
+        case 0:
+        case 1:
+            nex.poll();
+            break;
+        case 2:
+        {
+            String text;
+            nex.receiveString(text);
+            break;
+        }
+        case 3:
+        {
+            char text[8];
+            size_t received = nex.receiveString(text, sizeof(text));
+            if (received >= sizeof(text) || strnlen(text, sizeof(text)) != received)
+            {
+                __builtin_trap();
+            }
+            break;
+        }
+        case 4:
+        {
+            uint32_t number = 0;
+            nex.receiveNumber(number);
+            break;
+        }
+        case 5:
+        {
+            uint32_t numbers[4];
+            uint8_t status[4];
+            if (nex.receiveNumbers(numbers, status, 4) > 4)
+            {
+                __builtin_trap();
+            }
+            break;
+        }
+        case 6:
+            nex.checkCommandComplete(true);
+            break;
+        case 7:
+        {
+            uint8_t page = 0;
+            nex.getCurrentPage(page);
+            break;
+        }
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        nex.poll();
+    }
+    return 0;
+}
+
+#ifndef NEXTION_LIBFUZZER
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::ifstream(argv[1]).good())
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::ifstream file(argv[i], std::ios::binary);
+            std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+        printf("%d input(s) run\n", argc - 1);
+        return 0;
+    }
+
+    int runs = argc > 1 ? atoi(argv[1]) : 1000;
+    std::mt19937 random(49);
+    std::vector<uint8_t> input;
+    for (int run = 0; run < runs; run++)
+    {
+        input.resize(random() % 512);
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            // Termination bytes and known headers make framing more likely
+            uint32_t r = random();
+            static const uint8_t headers[] = {0x01, 0x65, 0x66, 0x70, 0x71, 0x80, 0x88, 0xFF};
+            input[i] = r % 3 == 0 ? headers[(r >> 8) % sizeof(headers)] : r >> 16;
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("%d random input(s) run\n", runs);
+    return 0;
+}
+#endif
@@ -0,0 +1,73 @@
+/*! \file */
+
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+unsigned long millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return 0;
+}
+
+/*!
+ * \class StdoutStream
+ * \brief Serial port of the host, writes to stdout and never receives.
+ */
+class StdoutStream : public Stream
+{
+public:
+    size_t write(uint8_t b)
+    {
+        return fputc(b, stdout) == EOF ? 0 : 1;
+    }
+
+    int available()
+    {
+        return 0;
+    }
+
+    int read()
+    {
+        return -1;
+    }
+
+    int peek()
+    {
+        return -1;
+    }
+
+    void flush()
+    {
+        fflush(stdout);
+    }
+};
+
+static StdoutStream stdoutStream;
+Stream &Serial = stdoutStream;
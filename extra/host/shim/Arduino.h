@@ -0,0 +1,203 @@
+/*! \file */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WString.h"
+
+#define ARDUINO 10800
+#define NEXTION_HOST 1 //!< Built on a PC by the host harness
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+uint32_t getCpuFrequencyMhz();
+
+/*!
+ * \class Print
+ * \brief Host stand-in for the Arduino Print.
+ */
+class Print
+{
+public:
+    virtual ~Print()
+    {
+    }
+
+    virtual size_t write(uint8_t b) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t written = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            written += write(buffer[i]);
+        }
+        return written;
+    }
+
+    size_t write(const char *buffer, size_t size)
+    {
+        return write(reinterpret_cast<const uint8_t *>(buffer), size);
+    }
+
+    size_t write(const char *str)
+    {
+        return write(str, strlen(str));
+    }
+
+    size_t print(const char *str)
+    {
+        return write(str);
+    }
+
+    size_t print(const String &str)
+    {
+        return write(str.c_str());
+    }
+
+    size_t print(char c)
+    {
+        return write(static_cast<uint8_t>(c));
+    }
+
+    size_t print(int value, int base = 10)
+    {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), base == 16 ? "%X" : "%d", value);
+        return write(buffer);
+    }
+
+    size_t println()
+    {
+        return write("\r\n");
+    }
+
+    size_t println(const char *str)
+    {
+        return print(str) + println();
+    }
+
+    size_t println(const String &str)
+    {
+        return print(str) + println();
+    }
+
+    size_t println(int value)
+    {
+        return print(value) + println();
+    }
+
+    size_t printf(const char *format, ...)
+    {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0)
+        {
+            return 0;
+        }
+        return write(buffer, static_cast<size_t>(length) < sizeof(buffer) ? length : sizeof(buffer) - 1);
+    }
+
+    virtual void flush()
+    {
+    }
+};
+
+/*!
+ * \class Stream
+ * \brief Host stand-in for the Arduino Stream, reads time out after 1 s.
+ */
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void begin(unsigned long)
+    {
+    }
+
+    void setTimeout(unsigned long timeout)
+    {
+        m_timeout = timeout;
+    }
+
+    size_t readBytes(uint8_t *buffer, size_t length)
+    {
+        size_t count = 0;
+        while (count < length)
+        {
+            int c = timedRead();
+            if (c < 0)
+            {
+                break;
+            }
+            buffer[count++] = static_cast<uint8_t>(c);
+        }
+        return count;
+    }
+
+    size_t readBytes(char *buffer, size_t length)
+    {
+        return readBytes(reinterpret_cast<uint8_t *>(buffer), length);
+    }
+
+    bool find(const uint8_t *target, size_t length)
+    {
+        size_t matched = 0;
+        while (matched < length)
+        {
+            int c = timedRead();
+            if (c < 0)
+            {
+                return false;
+            }
+            if (c == target[matched])
+            {
+                ++matched;
+            }
+            else
+            {
+                matched = c == target[0] ? 1 : 0;
+            }
+        }
+        return true;
+    }
+
+    bool find(uint8_t *target, size_t length)
+    {
+        return find(const_cast<const uint8_t *>(target), length);
+    }
+
+protected:
+    unsigned long m_timeout = 1000; //!< Timeout of reads in ms
+
+    int timedRead()
+    {
+        unsigned long start = millis();
+        do
+        {
+            int c = read();
+            if (c >= 0)
+            {
+                return c;
+            }
+        } while (millis() - start < m_timeout);
+        return -1;
+    }
+};
+
+extern Stream &Serial;
@@ -0,0 +1,78 @@
+/*! \file */
+
+#pragma once
+
+#include "Arduino.h"
+
+namespace fs
+{
+
+/*!
+ * \class File
+ * \brief Host stand-in for an always empty file.
+ */
+class File : public Stream
+{
+public:
+    size_t write(uint8_t)
+    {
+        return 0;
+    }
+
+    int available()
+    {
+        return 0;
+    }
+
+    int read()
+    {
+        return -1;
+    }
+
+    int peek()
+    {
+        return -1;
+    }
+
+    size_t size()
+    {
+        return 0;
+    }
+
+    void close()
+    {
+    }
+
+    operator bool() const
+    {
+        return false;
+    }
+};
+
+/*!
+ * \class FS
+ * \brief Host stand-in for a file system without files.
+ */
+class FS
+{
+public:
+    File open(const char *, const char * = "r")
+    {
+        return File();
+    }
+
+    File open(const String &, const char * = "r")
+    {
+        return File();
+    }
+
+    bool exists(const char *)
+    {
+        return false;
+    }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,35 @@
+/*! \file */
+
+#pragma once
+
+#include "Arduino.h"
+
+/*!
+ * \class MD5Builder
+ * \brief Host stand-in that counts the bytes added instead of hashing them.
+ */
+class MD5Builder
+{
+public:
+    void begin()
+    {
+        m_length = 0;
+    }
+
+    void add(const uint8_t *, size_t length)
+    {
+        m_length += length;
+    }
+
+    void calculate()
+    {
+    }
+
+    String toString()
+    {
+        return String(static_cast<unsigned long>(m_length));
+    }
+
+private:
+    size_t m_length = 0;
+};
@@ -0,0 +1,216 @@
+/*! \file */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+/*!
+ * \class String
+ * \brief Host stand-in for the Arduino String, backed by std::string.
+ */
+class String
+{
+public:
+    String(const char *str = "")
+        : m_str(str ? str : "")
+    {
+    }
+
+    String(const std::string &str)
+        : m_str(str)
+    {
+    }
+
+    explicit String(char c)
+        : m_str(1, c)
+    {
+    }
+
+    String(int value)
+        : m_str(std::to_string(value))
+    {
+    }
+
+    String(unsigned int value)
+        : m_str(std::to_string(value))
+    {
+    }
+
+    String(long value)
+        : m_str(std::to_string(value))
+    {
+    }
+
+    String(unsigned long value)
+        : m_str(std::to_string(value))
+    {
+    }
+
+    String(double value, unsigned char decimals = 2)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        m_str = buffer;
+    }
+
+    const char *c_str() const
+    {
+        return m_str.c_str();
+    }
+
+    unsigned int length() const
+    {
+        return m_str.size();
+    }
+
+    bool isEmpty() const
+    {
+        return m_str.empty();
+    }
+
+    bool reserve(unsigned int size)
+    {
+        m_str.reserve(size);
+        return true;
+    }
+
+    void clear()
+    {
+        m_str.clear();
+    }
+
+    bool concat(char c)
+    {
+        m_str += c;
+        return true;
+    }
+
+    bool concat(const char *str)
+    {
+        m_str += str;
+        return true;
+    }
+
+    bool concat(const String &str)
+    {
+        m_str += str.m_str;
+        return true;
+    }
+
+    String &operator+=(const String &str)
+    {
+        m_str += str.m_str;
+        return *this;
+    }
+
+    String &operator+=(const char *str)
+    {
+        m_str += str;
+        return *this;
+    }
+
+    String &operator+=(char c)
+    {
+        m_str += c;
+        return *this;
+    }
+
+    friend String operator+(const String &a, const String &b)
+    {
+        return String(a.m_str + b.m_str);
+    }
+
+    friend String operator+(const String &a, const char *b)
+    {
+        return String(a.m_str + b);
+    }
+
+    friend String operator+(const char *a, const String &b)
+    {
+        return String(a + b.m_str);
+    }
+
+    bool operator==(const String &str) const
+    {
+        return m_str == str.m_str;
+    }
+
+    bool operator!=(const String &str) const
+    {
+        return m_str != str.m_str;
+    }
+
+    bool operator==(const char *str) const
+    {
+        return m_str == str;
+    }
+
+    bool equals(const String &str) const
+    {
+        return m_str == str.m_str;
+    }
+
+    char operator[](unsigned int index) const
+    {
+        return m_str[index];
+    }
+
+    char &operator[](unsigned int index)
+    {
+        return m_str[index];
+    }
+
+    long toInt() const
+    {
+        return atol(m_str.c_str());
+    }
+
+    void toCharArray(char *buffer, unsigned int size) const
+    {
+        snprintf(buffer, size, "%s", m_str.c_str());
+    }
+
+    bool startsWith(const String &prefix) const
+    {
+        return m_str.compare(0, prefix.m_str.size(), prefix.m_str) == 0;
+    }
+
+    int indexOf(char c) const
+    {
+        size_t pos = m_str.find(c);
+        return pos == std::string::npos ? -1 : static_cast<int>(pos);
+    }
+
+    String substring(unsigned int from) const
+    {
+        return String(m_str.substr(from));
+    }
+
+    String substring(unsigned int from, unsigned int to) const
+    {
+        return String(m_str.substr(from, to - from));
+    }
+
+    void remove(unsigned int index, unsigned int count = 1)
+    {
+        m_str.erase(index, count);
+    }
+
+    void trim()
+    {
+        const char *space = " \t\r\n";
+        size_t first = m_str.find_first_not_of(space);
+        if (first == std::string::npos)
+        {
+            m_str.clear();
+            return;
+        }
+        m_str = m_str.substr(first, m_str.find_last_not_of(space) - first + 1);
+    }
+
+private:
+    std::string m_str;
+};
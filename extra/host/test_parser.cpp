@@ -0,0 +1,331 @@
+/*! \file */
+
+/*
+ * Host tests of the receive parser: framing of fixed length messages,
+ * recovery from broken and oversized input, and bounds on memory, time and
+ * throughput for random input.
+ */
+
+#include <new>
+#include <random>
+
+#include "FakeDisplay.h"
+#include "Nextion.h"
+#include "NextionButton.h"
+#include "NextionPage.h"
+
+static int failures = 0;
+
+#define CHECK(condition)                                                             \
+    do                                                                               \
+    {                                                                                \
+        if (!(condition))                                                            \
+        {                                                                            \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                              \
+        }                                                                            \
+    } while (0)
+
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+
+// Not inlined, so the compiler does not pair the malloc() and free() inside
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    size_t *block = static_cast<size_t *>(malloc(size + sizeof(size_t)));
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    block[0] = size;
+    liveBytes += size;
+    peakBytes = std::max(peakBytes, liveBytes);
+    return block + 1;
+}
+
+__attribute__((noinline)) void operator delete(void *ptr) noexcept
+{
+    if (ptr)
+    {
+        size_t *block = static_cast<size_t *>(ptr) - 1;
+        liveBytes -= block[0];
+        free(block);
+    }
+}
+
+/*!
+ * \brief Resets the peak of allocated memory to the current use.
+ * \return Bytes currently allocated
+ */
+static size_t resetPeak()
+{
+    peakBytes = liveBytes;
+    return liveBytes;
+}
+
+/*!
+ * \brief Driver connected to a fake display, with buttons 1 to 3 on page 1
+ *        counting their presses.
+ */
+struct Fixture
+{
+    FakeDisplay display;
+    Nextion nex;
+    NextionButton buttons[3];
+    int presses[3];
+
+    Fixture()
+        : nex(display, 50)
+        , buttons{NextionButton(nex, 1, 1, "b0"), NextionButton(nex, 1, 2, "b1"), NextionButton(nex, 1, 3, "b2")}
+        , presses{0, 0, 0}
+    {
+        nex.init();
+        for (int i = 0; i < 3; i++)
+        {
+            buttons[i].attachCallback([this, i](NextionEventType type, INextionTouchable *) {
+                if (type == NEX_EVENT_PUSH)
+                {
+                    ++presses[i];
+                }
+            });
+        }
+    }
+
+    void poll(int times = 4)
+    {
+        for (int i = 0; i < times; i++)
+        {
+            nex.poll();
+        }
+    }
+};
+
+static void testFixedLengthPayload()
+{
+    Fixture f;
+
+    // Payload bytes of 0xFF do not terminate fixed length messages
+    uint32_t value = 0;
+    f.display.inject({0x71, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    CHECK(f.nex.receiveNumber(value));
+    CHECK(value == 0xFFFFFFFF);
+
+    f.display.inject({0x65, 0x01, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+    f.poll();
+    CHECK(f.presses[2] == 1);
+    CHECK(f.nex.getParseErrorCount() == 0);
+}
+
+static void testSplitFrames()
+{
+    Fixture f;
+
+    f.display.inject({0x65, 0x01, 0x02});
+    uint32_t start = millis();
+    f.poll();
+    // A partial message must not block polling
+    CHECK(millis() - start < 5);
+    CHECK(f.presses[1] == 0);
+
+    f.display.inject({0x01, 0xFF, 0xFF, 0xFF});
+    f.poll();
+    CHECK(f.presses[1] == 1);
+}
+
+static void testLostByte()
+{
+    Fixture f;
+
+    // Touch event missing its event type, followed by a complete one
+    f.display.inject({0x65, 0x01, 0x02, 0xFF, 0xFF, 0xFF});
+    f.display.inject({0x65, 0x01, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+    f.poll();
+    CHECK(f.presses[1] == 0);
+    CHECK(f.presses[2] == 1);
+    CHECK(f.nex.getParseErrorCount() == 1);
+}
+
+static void testRemainderReframed()
+{
+    Fixture f;
+
+    // A broken value notification, a command result and a touch event. The
+    // bytes after the broken message are framed again, even though they are
+    // already longer than the command result.
+    f.display.inject({0x80, 0xFF, 0xFF, 0xFF});
+    f.display.inject({0x01, 0xFF, 0xFF, 0xFF});
+    f.display.inject({0x65, 0x01, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+    f.poll();
+    CHECK(f.presses[2] == 1);
+    CHECK(f.nex.checkCommandComplete());
+    CHECK(f.nex.getParseErrorCount() == 1);
+
+    // A broken restart event must not trigger a recovery
+    f.display.inject({0x80, 0xFF, 0xFF, 0xFF, 0x88, 0x01, 0x02, 0x03, 0x04, 0x05});
+    f.display.inject({0xFF, 0xFF, 0xFF});
+    f.display.inject({0x65, 0x01, 0x01, 0x01, 0xFF, 0xFF, 0xFF});
+    f.poll();
+    CHECK(f.nex.getRecoveryCount() == 0);
+    CHECK(f.presses[0] == 1);
+}
+
+static void testEventTimestamp()
+{
+    Fixture f;
+    uint32_t timestamp = 0;
+    f.buttons[0].attachCallback([&f, &timestamp](NextionEventType, INextionTouchable *) {
+        timestamp = f.nex.getEventTimestamp();
+    });
+
+    // Received while a command waits for its reply, dispatched by the next poll
+    f.display.setAcknowledge(false);
+    f.nex.sendCommand("ref 0");
+    uint32_t received = micros();
+    f.display.inject({0x65, 0x01, 0x01, 0x01, 0xFF, 0xFF, 0xFF});
+    CHECK(!f.nex.checkCommandComplete());
+    f.poll();
+    CHECK(timestamp - received < 5000);
+}
+
+static void testSlowCommand()
+{
+    Fixture f;
+    NextionPage page(f.nex, 1, 0, "page1");
+
+    // Quick acknowledgements shorten the timeouts to the minimum
+    for (int i = 0; i < 16; i++)
+    {
+        f.nex.sendCommand("n0.val=1");
+        CHECK(f.nex.checkCommandComplete());
+    }
+
+    // The device takes a while to show a page
+    f.display.setReplyDelay("page ", 35);
+    CHECK(page.show());
+    uint32_t value = 1;
+    f.nex.sendCommand("get n0.val");
+    CHECK(f.nex.receiveNumber(value));
+    CHECK(value == 0);
+
+    // A late reply is not taken for the reply to the next command
+    f.display.setReplyDelay("n0.val=2", 35);
+    f.nex.sendCommand("n0.val=2");
+    CHECK(!f.nex.checkCommandComplete());
+    value = 1;
+    f.nex.sendCommand("get n0.val");
+    CHECK(f.nex.receiveNumber(value));
+    CHECK(value == 0);
+    f.nex.sendCommand("n0.val=3");
+    CHECK(f.nex.checkCommandComplete());
+    CHECK(f.nex.getLinkMonitor().isAlive());
+}
+
+static void testOversizedInput()
+{
+    Fixture f;
+
+    std::vector<uint8_t> garbage(5000, 0x20);
+    f.display.inject(&garbage[0], garbage.size());
+    f.display.inject({0xFF, 0xFF, 0xFF});
+    f.display.inject({0x65, 0x01, 0x02, 0x01, 0xFF, 0xFF, 0xFF});
+    size_t baseline = resetPeak();
+    f.poll(8);
+    CHECK(f.presses[1] == 1);
+    CHECK(f.nex.getParseErrorCount() == 1);
+    // Bounded by NEXTION_MAX_MESSAGE_LENGTH, not by the input
+    CHECK(peakBytes - baseline <= 2 * NEXTION_MAX_MESSAGE_LENGTH + 1024);
+}
+
+static void testRandomInput()
+{
+    Fixture f;
+    size_t baseline = resetPeak();
+    std::mt19937 random(49);
+
+    uint32_t longestPoll = 0;
+    uint32_t start = millis();
+    std::vector<uint8_t> chunk;
+    for (size_t total = 0; total < 200000; total += chunk.size())
+    {
+        chunk.resize(random() % 64 + 1);
+        for (size_t i = 0; i < chunk.size(); i++)
+        {
+            chunk[i] = random() % 4 == 0 ? 0xFF : random();
+        }
+        f.display.inject(&chunk[0], chunk.size());
+
+        uint32_t pollStart = micros();
+        f.nex.poll();
+        longestPoll = std::max<uint32_t>(longestPoll, micros() - pollStart);
+    }
+    uint32_t elapsed = millis() - start;
+    f.poll(1000);
+
+    printf("  200000 random bytes in %u ms, longest poll %u us, peak %u bytes, %u parse errors\n",
+           elapsed, longestPoll, static_cast<unsigned>(peakBytes - baseline), f.nex.getParseErrorCount());
+    CHECK(elapsed < 2000);
+    CHECK(longestPoll < 200000);
+    CHECK(peakBytes - baseline <= NEXTION_SOLICITED_BUFFER_LIMIT + 4 * NEXTION_MAX_MESSAGE_LENGTH + 4096);
+
+    // The parser recovers once a termination was received
+    f.display.inject({0xFF, 0xFF, 0xFF});
+    f.display.inject({0x65, 0x01, 0x02, 0x01, 0xFF, 0xFF, 0xFF});
+    f.display.inject({0x65, 0x01, 0x02, 0x01, 0xFF, 0xFF, 0xFF});
+    int before = f.presses[1];
+    f.poll(8);
+    CHECK(f.presses[1] - before >= 1);
+}
+
+static void testThroughput()
+{
+    Fixture f;
+
+    const size_t events = 20000;
+    for (size_t i = 0; i < events; i++)
+    {
+        f.display.inject({0x65, 0x01, 0x03, 0x01, 0xFF, 0xFF, 0xFF});
+    }
+
+    uint32_t start = micros();
+    while (f.display.available() > 0)
+    {
+        f.nex.poll();
+    }
+    uint32_t elapsed = std::max<uint32_t>(micros() - start, 1);
+
+    // The parser has to keep up with the fastest baud rate of the display
+    double rate = events * 7 * 1e6 / elapsed;
+    printf("  %u touch events in %u us, %.0f bytes/s\n", static_cast<unsigned>(events), elapsed, rate);
+    CHECK(f.presses[2] == static_cast<int>(events));
+    CHECK(rate > 921600 / 10);
+}
+
+int main()
+{
+    struct
+    {
+        const char *name;
+        void (*run)();
+    } tests[] = {
+        {"fixed_length_payload", &testFixedLengthPayload},
+        {"split_frames", &testSplitFrames},
+        {"lost_byte", &testLostByte},
+        {"remainder_reframed", &testRemainderReframed},
+        {"event_timestamp", &testEventTimestamp},
+        {"slow_command", &testSlowCommand},
+        {"oversized_input", &testOversizedInput},
+        {"random_input", &testRandomInput},
+        {"throughput", &testThroughput},
+    };
+
+    for (auto &test : tests)
+    {
+        int before = failures;
+        printf("%s\n", test.name);
+        test.run();
+        printf("  %s\n", failures == before ? "ok" : "FAILED");
+    }
+
+    printf("%d check(s) failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}